@@ -0,0 +1,213 @@
+#pragma once
+
+#include "shared_memory.hpp"
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace cutty
+{
+/**
+    Accesses a file through a fixed pool of in-memory frames, instead of memory-mapping it.
+
+    With shared_memory, pages are loaded by page faults and evicted by the kernel, so there
+    is no control over memory use, eviction or I/O concurrency. buffer_pool reads pages into
+    a fixed number of frames using pread, writes modified pages back using pwrite, and evicts
+    pages using the clock algorithm. The direct option bypasses the kernel's page cache.
+
+    A page is accessed by pinning it, which loads it if necessary and prevents it from being
+    evicted until the pin is released. Pages can be prefetched by a pool of I/O threads.
+
+    All operations are thread-safe. Not supported on Windows.
+ */
+class buffer_pool
+{
+  public:
+    using size_type = shared_memory::size_type;
+
+    struct options
+    {
+        /// The size of each page, which is rounded up to a multiple of 4096
+        size_type page_size = 65536;
+
+        /// The number of frames, which bounds the memory used
+        std::size_t frames = 256;
+
+        /// The number of threads used for prefetching
+        unsigned io_threads = 4;
+
+        /// Use O_DIRECT to bypass the page cache, where supported
+        bool direct = false;
+    };
+
+    struct statistics
+    {
+        std::size_t hits = 0;      /// Pins of pages that were already loaded
+        std::size_t misses = 0;    /// Pins of pages that needed to be read
+        std::size_t evictions = 0; /// Pages evicted to make room
+        std::size_t writes = 0;    /// Dirty pages written
+    };
+
+  private:
+    struct frame
+    {
+        size_type page;
+        unsigned pins = 0;
+        bool referenced = false;
+        bool dirty = false;
+        bool loading = false;
+        bool used = false;
+    };
+
+  public:
+    /**
+        A pinned page. The page remains in memory until the pin is destroyed.
+     */
+    class pin
+    {
+      public:
+        /** Creates an empty pin */
+        pin();
+
+        pin(pin &&src);
+        pin &operator=(pin &&src);
+
+        pin(const pin &) = delete;
+        pin &operator=(const pin &) = delete;
+
+        ~pin();
+
+        /** Returns the page's data, or nullptr if empty */
+        void *data() const
+        {
+            return m_data;
+        }
+
+        /** Returns the size of the page, which is smaller than the page size at the end of the file */
+        size_type size() const
+        {
+            return m_size;
+        }
+
+        size_type page() const
+        {
+            return m_page;
+        }
+
+        explicit operator bool() const
+        {
+            return m_data;
+        }
+
+        /** Records that the page has been modified, so it is written back when evicted or flushed */
+        void mark_dirty();
+
+        /** Releases the pin and empties it */
+        void release();
+
+      private:
+        friend buffer_pool;
+        pin(buffer_pool *pool, std::size_t frame, size_type page, void *data, size_type size);
+
+        buffer_pool *m_pool;
+        std::size_t m_frame;
+        size_type m_page;
+        void *m_data;
+        size_type m_size;
+    };
+
+    /** Creates an empty buffer_pool */
+    buffer_pool();
+
+    /**
+        Opens or creates a file, with the default options.
+        @p flags are shared_memory::flags. If the file is less than @p min_size, it is extended.
+        If the operation failed, the buffer_pool is empty and ec contains the error code.
+     */
+    buffer_pool(const char *filename, std::error_code &ec, int flags = shared_memory::create, size_type min_size = 0);
+
+    buffer_pool(const char *filename, std::error_code &ec, int flags, size_type min_size, const options &opts);
+
+    buffer_pool(const buffer_pool &) = delete;
+    buffer_pool &operator=(const buffer_pool &) = delete;
+
+    /** Writes back dirty pages and closes the file. All pins must have been released. */
+    ~buffer_pool();
+
+    explicit operator bool() const
+    {
+        return m_fd >= 0;
+    }
+
+    /** Returns the size of the file */
+    size_type size() const;
+
+    size_type page_size() const
+    {
+        return m_page_size;
+    }
+
+    std::size_t frame_count() const
+    {
+        return m_frames.size();
+    }
+
+    /** Returns the number of pages in the file */
+    size_type page_count() const;
+
+    /**
+        Pins a page, reading it from the file if necessary.
+        Fails with no_buffer_space if every frame is pinned.
+     */
+    pin get(std::error_code &ec, size_type page);
+
+    /** Starts reading a page on an I/O thread, if it is not already loaded */
+    void prefetch(size_type page);
+
+    /** Writes all dirty pages back to the file */
+    void flush(std::error_code &ec);
+
+    /** Resizes the file. Cached pages beyond the new size must not be pinned. */
+    void resize(std::error_code &ec, size_type new_size);
+
+    statistics stats() const;
+
+    /** Writes back dirty pages, stops the I/O threads and closes the file */
+    void close();
+
+  private:
+    int m_fd;
+    bool m_direct;
+    size_type m_size, m_page_size;
+    std::byte *m_memory;
+    std::vector<frame> m_frames;
+    std::unordered_map<size_type, std::size_t> m_page_table;
+    std::size_t m_clock;
+    statistics m_stats;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_loaded;
+
+    std::deque<size_type> m_prefetch;
+    std::condition_variable m_prefetch_ready;
+    bool m_stop;
+    std::vector<std::thread> m_io_threads;
+
+    std::byte *frame_data(std::size_t f) const
+    {
+        return m_memory + f * m_page_size;
+    }
+
+    void unpin(std::size_t f);
+    bool load(std::unique_lock<std::mutex> &lock, std::error_code &ec, size_type page, std::size_t &f);
+    bool find_victim(std::size_t &f);
+    void write_page(std::error_code &ec, std::size_t f, size_type page, size_type file_size);
+    void read_page(std::error_code &ec, std::size_t f, size_type page);
+    void run_io();
+};
+} // namespace cutty
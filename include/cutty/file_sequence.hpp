@@ -0,0 +1,147 @@
+#pragma once
+
+#include "sequence.hpp"
+#include "shared_memory.hpp"
+
+#include <concepts>
+#include <memory>
+#include <system_error>
+#include <type_traits>
+
+namespace cutty
+{
+/**
+    A sequence that keeps a memory mapping alive while it refers to the mapped memory.
+
+    Adaptors such as where() and select() store a copy of this sequence, and lines(), split_view(),
+    csv() and records() give mapped_sequences, so every sequence created from a file shares its mapping.
+    Elements that refer to the memory, such as lines, must not outlive the last sequence that shares it.
+ */
+template <typename Seq>
+class mapped_sequence : public sequences::base_sequence<typename Seq::value_type, mapped_sequence<Seq>>
+{
+    Seq seq;
+    std::shared_ptr<const shared_memory> m_memory;
+
+  public:
+    typedef typename Seq::value_type value_type;
+
+    mapped_sequence(const Seq &seq, std::shared_ptr<const shared_memory> memory)
+        : seq(seq), m_memory(std::move(memory))
+    {
+    }
+
+    const value_type *first()
+    {
+        return seq.first();
+    }
+
+    const value_type *next()
+    {
+        return seq.next();
+    }
+
+    template <typename Fn> bool iterate(Fn fn) const
+    {
+        return seq.iterate(fn);
+    }
+
+    sequences::helpers::size_hint size_hint() const
+    {
+        return seq.size_hint();
+    }
+
+    std::size_t size() const
+    {
+        return seq.size();
+    }
+
+    const value_type &element(std::size_t i)
+        requires sequences::helpers::random_access_sequence<Seq>
+    {
+        return seq.element(i);
+    }
+
+    auto slice(std::size_t begin, std::size_t end) const
+        requires sequences::helpers::splittable_sequence<Seq>
+    {
+        return share(seq.slice(begin, end));
+    }
+
+    std::size_t split_size() const
+        requires sequences::helpers::splittable_sequence<Seq>
+    {
+        return seq.split_size();
+    }
+
+    const value_type *data() const
+        requires sequences::helpers::contiguous_sequence<Seq>
+    {
+        return seq.data();
+    }
+
+    // These hide the versions in base_sequence, which do not share the mapping
+
+    auto csv(value_type delimiter = ',') const
+        requires sequences::helpers::contiguous_sequence<Seq>
+    {
+        return share(seq.csv(delimiter));
+    }
+
+    auto lines() const
+        requires sequences::helpers::contiguous_sequence<Seq>
+    {
+        return share(seq.lines());
+    }
+
+    auto split_view(const value_type *splitChars) const
+        requires sequences::helpers::contiguous_sequence<Seq>
+    {
+        return share(seq.split_view(splitChars));
+    }
+
+    /**
+        The bytes as a sequence of fixed-size records of type T.
+        Any partial record at the end is ignored.
+     */
+    template <typename T> mapped_sequence<pointer_sequence<T>> records() const
+        requires std::same_as<value_type, char> && sequences::helpers::contiguous_sequence<Seq>
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "records must be trivially copyable");
+        auto p = reinterpret_cast<const T *>(data());
+        return share(pointer_sequence<T>(p, p + size() / sizeof(T)));
+    }
+
+  private:
+    template <typename Seq2> mapped_sequence<Seq2> share(const Seq2 &s) const
+    {
+        return {s, m_memory};
+    }
+};
+
+/**
+    A sequence of the bytes in a file, which is memory-mapped instead of being read.
+
+    The file is mapped read-only, with a hint to read ahead sequentially.
+    Copies, and sequences created from a file_sequence such as lines() or where(), share the same mapping,
+    which is unmapped when the last of them is destroyed.
+ */
+class file_sequence : public mapped_sequence<pointer_sequence<char>>
+{
+  public:
+    /** Maps the file, throwing std::system_error on failure */
+    explicit file_sequence(const char *path);
+
+    /** Maps the file. On failure, ec contains the error and the sequence is empty */
+    file_sequence(const char *path, std::error_code &ec);
+
+  private:
+    file_sequence(std::shared_ptr<const shared_memory> memory);
+};
+
+/** Maps a file as a sequence of bytes, throwing std::system_error on failure */
+file_sequence seq_file(const char *path);
+
+/** Maps a file as a sequence of bytes. On failure, ec contains the error and the sequence is empty */
+file_sequence seq_file(const char *path, std::error_code &ec);
+} // namespace cutty
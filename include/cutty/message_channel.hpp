@@ -0,0 +1,124 @@
+#pragma once
+
+#include "shared_memory.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <span>
+
+namespace cutty
+{
+/**
+    A single-producer, single-consumer channel of variable-length messages in shared memory.
+
+    Messages are written in place into a ring buffer, and are read in place, so they are never copied.
+    The producer calls reserve() to get space for a message, writes the message, then calls commit().
+    The consumer calls read() to get the next message, and release() when it has finished with it.
+
+    The head and tail counters are on separate cache lines, so the producer and consumer do not
+    contend. A blocked producer or consumer sleeps on a futex (on Linux), and is only woken if it
+    is waiting, so the fast path makes no system calls.
+
+    The producer and consumer are normally in different processes, each with its own message_channel
+    on the same file or anonymous memory. One process should create the channel before the other opens it.
+ */
+class message_channel
+{
+  public:
+    using size_type = shared_memory::size_type;
+    using duration = std::chrono::nanoseconds;
+
+    static constexpr size_type default_capacity = 1 << 20;
+
+    /** Creates an empty message_channel */
+    message_channel();
+
+    /**
+        Opens or creates a channel in a file.
+        @p capacity is the size of the ring, which is rounded up to a power of 2.
+        When opening an existing channel, its capacity is used instead.
+     */
+    message_channel(const char *filename, std::error_code &ec, size_type capacity = default_capacity,
+                    int flags = shared_memory::create);
+
+    /**
+        Opens or creates a channel in shared memory, for example anonymous memory
+        shared using send_fd(). The memory is resized if it is too small.
+     */
+    message_channel(shared_memory &&memory, std::error_code &ec, size_type capacity = default_capacity);
+
+    message_channel(const message_channel &) = delete;
+    message_channel &operator=(const message_channel &) = delete;
+
+    /** Returns if the channel is open */
+    explicit operator bool() const
+    {
+        return m_header;
+    }
+
+    /** The size of the ring */
+    size_type capacity() const;
+
+    /** The largest message that can be sent */
+    size_type max_message_size() const;
+
+    /** The underlying shared memory, for example to share its fd() */
+    shared_memory &memory()
+    {
+        return m_memory;
+    }
+
+    // Producer
+
+    /**
+        Reserves space for a message of @p size bytes, without blocking.
+        Returns an empty span with a null data() if there is not enough space.
+     */
+    std::span<std::byte> reserve(size_type size);
+
+    /**
+        Reserves space for a message, waiting up to @p timeout for the consumer to make space.
+     */
+    std::span<std::byte> reserve(size_type size, duration timeout);
+
+    /**
+        Publishes the reserved message to the consumer.
+        @p size may be smaller than the reserved size.
+     */
+    void commit(size_type size);
+
+    /** Copies a message into the channel. Returns false if there is not enough space. */
+    bool try_send(std::span<const std::byte> message);
+
+    // Consumer
+
+    /**
+        Returns the next message without blocking, or a span with a null data() if there are no messages.
+        The message remains valid until release() is called.
+     */
+    std::span<const std::byte> read();
+
+    /**
+        Returns the next message, waiting up to @p timeout for one to arrive.
+     */
+    std::span<const std::byte> read(duration timeout);
+
+    /** Releases the message returned by read(), so that its space can be reused */
+    void release();
+
+    /** Returns the number of bytes of messages waiting to be read */
+    size_type pending() const;
+
+  private:
+    struct header;
+
+    shared_memory m_memory;
+    header *m_header;
+    std::byte *m_ring;
+    size_type m_reserved, m_padding; // Producer state
+    size_type m_read, m_read_size;   // Consumer state
+
+    void open(std::error_code &ec, size_type capacity);
+};
+} // namespace cutty
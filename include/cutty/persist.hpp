@@ -10,6 +10,7 @@
 #include <memory>
 #include <mutex>
 #include <stdexcept>
+#include <type_traits>
 
 namespace cutty
 {
@@ -94,7 +95,12 @@ enum
     private_map = 2,
     temp_heap = 8,
     create_new = 16,
-    read_only = 32
+    read_only = 32,
+    huge_pages = 64,         // Use transparent huge pages to reduce TLB misses
+    sequential_access = 128, // The heap is mostly scanned
+    random_access = 256,     // The heap is mostly accessed randomly, so disable readahead
+    prefault = 512,          // Load the entire heap into memory when it is opened
+    preallocate = 1024       // Allocate disk blocks as the heap grows, so a full disk fails the allocation
 };
 
 // map_file
@@ -111,11 +117,25 @@ class map_file
     map_file(const char *filename, int applicationId, short majorVersion, short minorVersion, size_t length = 16384,
              size_t limit = 1000000, int flags = 0, size_t base = detail::default_map_address);
 
+    // Opens a heap in memory that is already mapped, such as anonymous shared memory
+    // received from another process. A new heap is created if the memory is empty.
+    map_file(shared_memory &&memory, int applicationId, short majorVersion, short minorVersion,
+             size_t limit = 1000000);
+
     ~map_file();
 
     void open(const char *filename, int applicationId, short majorVersion, short minorVersion, size_t length = 16384,
               size_t limit = 1000000, int flags = 0, size_t base = detail::default_map_address);
 
+    void open(shared_memory &&memory, int applicationId, short majorVersion, short minorVersion,
+              size_t limit = 1000000);
+
+    // The underlying shared memory, for example to pass its fd to another process
+    shared_memory &shared()
+    {
+        return memory;
+    }
+
     void close();
 
     // Returns true if the heap is valid and usable
@@ -170,6 +190,15 @@ class map_file
 
     bool extend_to(void *new_top);
 
+    // Returns free blocks at the top of the heap to the unallocated space,
+    // and shrinks the file to fit. Returns the number of bytes released.
+    // Must not be called concurrently with fast_malloc, or while other processes have the heap open.
+    size_t trim();
+
+    // Tells the operating system how a range of the heap will be accessed.
+    // A length of 0 means the rest of the heap.
+    void advise(std::error_code &ec, const void *address, size_t length, shared_memory::hint h);
+
     detail::shared_record &data()
     {
         return *(detail::shared_record *)memory.data();
@@ -200,6 +229,18 @@ template <class T> class fast_allocator : public std::allocator<T>
     typedef typename std::allocator<T>::difference_type difference_type;
     typedef typename std::allocator<T>::size_type size_type;
 
+    // The allocator refers to its map_file so cannot be reassigned.
+    // Containers keep their own allocator when they are assigned or swapped.
+    typedef std::false_type propagate_on_container_copy_assignment;
+    typedef std::false_type propagate_on_container_move_assignment;
+    typedef std::false_type propagate_on_container_swap;
+    typedef std::false_type is_always_equal;
+
+    template <class O> bool operator==(const fast_allocator<O> &other) const
+    {
+        return &map == &other.map;
+    }
+
     pointer allocate(size_type n)
     {
         pointer p = static_cast<pointer>(map.fast_malloc(n * sizeof(T)));
@@ -246,6 +287,18 @@ template <class T> class allocator : public std::allocator<T>
     typedef typename std::allocator<T>::difference_type difference_type;
     typedef typename std::allocator<T>::size_type size_type;
 
+    // The allocator refers to its map_file so cannot be reassigned.
+    // Containers keep their own allocator when they are assigned or swapped.
+    typedef std::false_type propagate_on_container_copy_assignment;
+    typedef std::false_type propagate_on_container_move_assignment;
+    typedef std::false_type propagate_on_container_swap;
+    typedef std::false_type is_always_equal;
+
+    template <class O> bool operator==(const allocator<O> &other) const
+    {
+        return &map == &other.map;
+    }
+
     pointer allocate(size_type n)
     {
         pointer p = static_cast<pointer>(map.malloc(n * sizeof(T)));
@@ -0,0 +1,299 @@
+// Implements an append-only column of values for persistent heaps.
+
+#pragma once
+
+#include "../persist.hpp"
+#include "../sequence.hpp"
+
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+
+namespace cutty::persist
+{
+/**
+    An append-only column of values, stored in fixed-size chunks.
+
+    Unlike a `std::vector`, growing a column never reallocates or copies the existing
+    elements, so pointers to elements remain valid and no blocks are left behind on
+    the heap's free list. Each chunk is contiguous, and is exposed as a `pointer_sequence`
+    so that scans run over plain memory.
+
+    A single writer may append while other threads (or processes sharing the heap)
+    read the elements that were present when they started their scan.
+
+    @p T The element type
+    @p ChunkSize The number of elements in each chunk
+    @p Allocator The allocator used to allocate chunks, normally `cutty::allocator`
+ */
+template <typename T, std::size_t ChunkSize = 4096, typename Allocator = cutty::allocator<T>> class column
+{
+    static_assert(ChunkSize > 0, "ChunkSize must be positive");
+
+    struct chunk
+    {
+        chunk *next;
+        alignas(T) unsigned char storage[ChunkSize * sizeof(T)];
+
+        T *data()
+        {
+            return reinterpret_cast<T *>(storage);
+        }
+
+        const T *data() const
+        {
+            return reinterpret_cast<const T *>(storage);
+        }
+    };
+
+    using chunk_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<chunk>;
+
+  public:
+    typedef T value_type;
+    typedef std::size_t size_type;
+    typedef Allocator allocator_type;
+
+    static constexpr size_type chunk_size = ChunkSize;
+
+    column(const Allocator &alloc = Allocator()) : alloc(alloc), head(nullptr), tail(nullptr), count(0)
+    {
+    }
+
+    column(const column &) = delete;
+    column &operator=(const column &) = delete;
+
+    ~column()
+    {
+        clear();
+    }
+
+    /** Returns the number of elements in the column */
+    size_type size() const
+    {
+        return count.load(std::memory_order_acquire);
+    }
+
+    /** Returns true if the column has no elements */
+    bool empty() const
+    {
+        return size() == 0;
+    }
+
+    /** Returns the number of chunks allocated */
+    size_type chunk_count() const
+    {
+        return (size() + ChunkSize - 1) / ChunkSize;
+    }
+
+    /**
+        Appends an element, constructing it in place.
+        The new element is visible to readers once this function returns.
+        Throws std::bad_alloc if the heap is full.
+     */
+    template <typename... Args> T &emplace_back(Args &&...args)
+    {
+        size_type n = count.load(std::memory_order_relaxed);
+        size_type offset = n % ChunkSize;
+
+        if (offset != 0)
+        {
+            T *result = new (tail->data() + offset) T(std::forward<Args>(args)...);
+            count.store(n + 1, std::memory_order_release);
+            return *result;
+        }
+
+        // Construct the element before linking the new chunk, so that a throwing constructor leaves no empty chunk
+        chunk *c = std::allocator_traits<chunk_allocator>::allocate(alloc, 1);
+        T *result;
+        try
+        {
+            result = new (c->data()) T(std::forward<Args>(args)...);
+        }
+        catch (...)
+        {
+            std::allocator_traits<chunk_allocator>::deallocate(alloc, c, 1);
+            throw;
+        }
+
+        c->next = nullptr;
+        if (tail)
+            tail->next = c;
+        else
+            head = c;
+        tail = c;
+        count.store(n + 1, std::memory_order_release);
+        return *result;
+    }
+
+    /** Appends a copy of @p value */
+    void push_back(const T &value)
+    {
+        emplace_back(value);
+    }
+
+    /**
+        Returns the element at the given index.
+        This walks the chunks so is O(index / ChunkSize).
+     */
+    const T &operator[](size_type index) const
+    {
+        const chunk *c = head;
+        for (size_type i = index / ChunkSize; i > 0; --i)
+            c = c->next;
+        return c->data()[index % ChunkSize];
+    }
+
+    T &operator[](size_type index)
+    {
+        return const_cast<T &>(static_cast<const column &>(*this)[index]);
+    }
+
+    /** Returns the element at the given index, or throws std::out_of_range */
+    const T &at(size_type index) const
+    {
+        if (index >= size())
+            throw std::out_of_range("at() is out of range");
+        return (*this)[index];
+    }
+
+    const T &back() const
+    {
+        size_type n = size();
+        if (n == 0)
+            throw std::out_of_range("back() called on an empty column");
+        return tail->data()[(n - 1) % ChunkSize];
+    }
+
+    /** Destroys all elements and releases all chunks */
+    void clear()
+    {
+        size_type remaining = count.load(std::memory_order_relaxed);
+        for (chunk *c = head; c;)
+        {
+            size_type n = remaining < ChunkSize ? remaining : ChunkSize;
+            std::destroy_n(c->data(), n);
+            remaining -= n;
+
+            chunk *next = c->next;
+            std::allocator_traits<chunk_allocator>::deallocate(alloc, c, 1);
+            c = next;
+        }
+        head = tail = nullptr;
+        count.store(0, std::memory_order_release);
+    }
+
+    // A sequence of the chunks in a column, where each chunk is a pointer_sequence.
+    class chunk_sequence : public sequences::base_sequence<pointer_sequence<T>, chunk_sequence>
+    {
+        const chunk *head, *c;
+        size_type total, remaining;
+        pointer_sequence<T> current;
+
+        const pointer_sequence<T> *load()
+        {
+            if (!c || remaining == 0)
+                return nullptr;
+            size_type n = remaining < ChunkSize ? remaining : ChunkSize;
+            current = {c->data(), c->data() + n};
+            return &current;
+        }
+
+      public:
+        typedef pointer_sequence<T> value_type;
+
+        chunk_sequence(const chunk *head, size_type total) : head(head), total(total), current(nullptr, nullptr)
+        {
+        }
+
+        const value_type *first()
+        {
+            c = head;
+            remaining = total;
+            return load();
+        }
+
+        const value_type *next()
+        {
+            remaining -= remaining < ChunkSize ? remaining : ChunkSize;
+            c = c->next;
+            return load();
+        }
+
+        size_type size() const
+        {
+            return (total + ChunkSize - 1) / ChunkSize;
+        }
+    };
+
+    // A sequence of all of the elements in a column, in order.
+    class value_sequence : public sequences::base_sequence<T, value_sequence>
+    {
+        const chunk *head, *c;
+        const T *current, *chunk_end;
+        size_type total, remaining;
+
+        const T *load()
+        {
+            if (!c || remaining == 0)
+                return nullptr;
+            size_type n = remaining < ChunkSize ? remaining : ChunkSize;
+            current = c->data();
+            chunk_end = current + n;
+            return current;
+        }
+
+      public:
+        typedef T value_type;
+
+        value_sequence(const chunk *head, size_type total) : head(head), total(total)
+        {
+        }
+
+        const T *first()
+        {
+            c = head;
+            remaining = total;
+            return load();
+        }
+
+        const T *next()
+        {
+            if (++current != chunk_end)
+                return current;
+            remaining -= chunk_end - c->data();
+            c = c->next;
+            return load();
+        }
+
+        size_type size() const
+        {
+            return total;
+        }
+    };
+
+    /**
+        Returns a sequence of chunks, each of which is a `pointer_sequence<T>`.
+        The sequence contains the elements present when this function is called.
+     */
+    chunk_sequence chunks() const
+    {
+        size_type n = size(); // Acquire before reading head
+        return {head, n};
+    }
+
+    /**
+        Returns a sequence of all elements.
+        The sequence contains the elements present when this function is called.
+     */
+    value_sequence values() const
+    {
+        size_type n = size(); // Acquire before reading head
+        return {head, n};
+    }
+
+  private:
+    chunk_allocator alloc;
+    chunk *head, *tail;
+    std::atomic<size_type> count;
+};
+} // namespace cutty::persist
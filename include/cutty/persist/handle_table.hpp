@@ -0,0 +1,336 @@
+// Implements relocatable handles, so that objects can be moved to compact a heap.
+
+#pragma once
+
+#include "../persist.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace cutty::persist
+{
+/**
+    A handle to an object in a handle_table.
+    The default-constructed handle is null.
+ */
+template <typename T> class relocatable
+{
+  public:
+    relocatable() : value(0)
+    {
+    }
+
+    explicit relocatable(std::uint32_t value) : value(value)
+    {
+    }
+
+    std::uint32_t id() const
+    {
+        return value;
+    }
+
+    explicit operator bool() const
+    {
+        return value != 0;
+    }
+
+    bool operator==(const relocatable &) const = default;
+
+  private:
+    std::uint32_t value;
+};
+
+/**
+    A table of handles to objects which can be moved by a compactor.
+
+    Objects are normally addressed by raw pointers, so a fragmented heap cannot be compacted.
+    Objects created through a handle_table are instead referred to by relocatable<T> handles,
+    and compact() can move them into free blocks lower in the heap. After compaction,
+    map_file::trim() releases the free space at the top of the heap and shrinks the file.
+
+    To access an object, pin it with a handle_table::pin, which prevents the object from
+    moving while the pin exists. compact() skips pinned objects, so it can run on a background
+    thread while other threads use the table.
+
+    Objects must be trivially copyable since they are moved using memcpy.
+ */
+template <typename Allocator = cutty::allocator<char>> class basic_handle_table
+{
+    struct slot
+    {
+        std::atomic<char *> ptr;         // The object, or nullptr if the slot is free
+        std::atomic<std::uint32_t> pins; // The number of pins, or moving while the slot is claimed or free
+        std::uint32_t size;              // The size of the object
+        std::uint32_t next_free;         // The next slot in the free list
+    };
+
+    static constexpr std::uint32_t moving = 0x80000000;
+    static constexpr std::size_t slots_per_chunk = 1024;
+    static constexpr std::size_t max_chunks = 4096;
+
+    using slot_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<slot>;
+
+  public:
+    typedef std::size_t size_type;
+
+    /** The maximum number of handles in a table */
+    static constexpr size_type max_size = slots_per_chunk * max_chunks;
+
+    basic_handle_table(const Allocator &alloc = Allocator()) : alloc(alloc), chunks{}, used(0), free_list(0), live(0)
+    {
+    }
+
+    basic_handle_table(const basic_handle_table &) = delete;
+    basic_handle_table &operator=(const basic_handle_table &) = delete;
+
+    ~basic_handle_table()
+    {
+        slot_allocator sa(alloc);
+        for (std::uint32_t i = 0; i < used; ++i)
+        {
+            auto &s = get_slot(i + 1);
+            if (auto p = s.ptr.load())
+                std::allocator_traits<Allocator>::deallocate(alloc, p, s.size);
+        }
+        for (auto c : chunks)
+            if (c)
+                std::allocator_traits<slot_allocator>::deallocate(sa, c, slots_per_chunk);
+    }
+
+    /** The number of live objects in the table */
+    size_type size() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return live;
+    }
+
+    /**
+        Creates an object in the heap and returns its handle.
+        Throws std::bad_alloc if the heap or the table is full.
+     */
+    template <typename T, typename... Args> relocatable<T> make(Args &&...args)
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "Relocatable objects must be trivially copyable");
+
+        char *p = std::allocator_traits<Allocator>::allocate(alloc, sizeof(T));
+        new (p) T(std::forward<Args>(args)...);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        std::uint32_t id;
+        if (free_list)
+        {
+            id = free_list;
+            free_list = get_slot(id).next_free;
+        }
+        else
+        {
+            if (used == max_size)
+            {
+                std::allocator_traits<Allocator>::deallocate(alloc, p, sizeof(T));
+                throw std::bad_alloc();
+            }
+            if (used % slots_per_chunk == 0)
+            {
+                slot_allocator sa(alloc);
+                auto c = std::allocator_traits<slot_allocator>::allocate(sa, slots_per_chunk);
+                for (std::size_t i = 0; i < slots_per_chunk; ++i)
+                    new (c + i) slot{nullptr, 0, 0, 0};
+                chunks[used / slots_per_chunk] = c;
+            }
+            id = ++used;
+        }
+
+        auto &s = get_slot(id);
+        s.size = sizeof(T);
+        s.ptr.store(p, std::memory_order_release);
+
+        // A reused slot stays claimed while it is free, so compact() cannot see it until now
+        s.pins.store(0, std::memory_order_release);
+        ++live;
+        return relocatable<T>(id);
+    }
+
+    /** Destroys the object. The object must not be pinned. */
+    template <typename T> void destroy(relocatable<T> handle)
+    {
+        // Claim the slot in the same way as compact(), and keep it claimed while it is free
+        auto &s = get_slot(handle.id());
+        wait_unpinned(s);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        std::allocator_traits<Allocator>::deallocate(alloc, s.ptr.exchange(nullptr), s.size);
+        s.next_free = free_list;
+        free_list = handle.id();
+        --live;
+    }
+
+    /**
+        Prevents an object from being moved while the pin exists, and gives access to it.
+     */
+    template <typename T> class pin
+    {
+      public:
+        pin(const basic_handle_table &table, relocatable<T> handle) : s(&table.get_slot(handle.id()))
+        {
+            for (auto p = s->pins.load(std::memory_order_relaxed);;)
+            {
+                if (p & moving)
+                {
+                    std::this_thread::yield();
+                    p = s->pins.load(std::memory_order_relaxed);
+                }
+                else if (s->pins.compare_exchange_weak(p, p + 1, std::memory_order_acquire))
+                    break;
+            }
+            ptr = reinterpret_cast<T *>(s->ptr.load(std::memory_order_acquire));
+        }
+
+        pin(const pin &) = delete;
+        pin &operator=(const pin &) = delete;
+
+        ~pin()
+        {
+            s->pins.fetch_sub(1, std::memory_order_release);
+        }
+
+        T *get() const
+        {
+            return ptr;
+        }
+
+        T &operator*() const
+        {
+            return *ptr;
+        }
+
+        T *operator->() const
+        {
+            return ptr;
+        }
+
+      private:
+        slot *s;
+        T *ptr;
+    };
+
+    /**
+        Returns the current address of an object without pinning it.
+        The address is only valid until the next call to compact().
+     */
+    template <typename T> T *get(relocatable<T> handle) const
+    {
+        return reinterpret_cast<T *>(get_slot(handle.id()).ptr.load(std::memory_order_acquire));
+    }
+
+    /**
+        Moves objects into free space lower in the heap, starting with the highest objects.
+        Objects that are pinned are skipped. Returns the number of objects moved.
+        @p max_moves limits the amount of work done in one call.
+        Compaction stops early if the heap is full and cannot provide a block to move into.
+     */
+    size_type compact(size_type max_moves = max_size)
+    {
+        std::vector<std::pair<char *, std::uint32_t>> objects;
+
+        // Blocks allocated above this address come from growing the heap, not from free space
+        char *limit = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (std::uint32_t id = 1; id <= used; ++id)
+            {
+                auto &s = get_slot(id);
+                if (auto p = s.ptr.load(std::memory_order_relaxed))
+                {
+                    objects.emplace_back(p, id);
+                    limit = std::max(limit, p + s.size);
+                }
+            }
+        }
+        std::sort(objects.begin(), objects.end(), [](auto &a, auto &b) { return a.first > b.first; });
+
+        // Blocks are only freed at the end, so that moved objects are not moved back into them
+        std::vector<std::pair<char *, std::uint32_t>> released;
+
+        size_type moved = 0;
+        for (auto [p, id] : objects)
+        {
+            if (moved == max_moves)
+                break;
+
+            // Free slots are claimed by destroy(), so a claimed slot has a live object whose size is fixed.
+            // It can be a new object that reused the slot since the snapshot.
+            auto &s = get_slot(id);
+            std::uint32_t unpinned = 0;
+            if (!s.pins.compare_exchange_strong(unpinned, moving, std::memory_order_acquire))
+                continue;
+
+            char *old = s.ptr.load(std::memory_order_relaxed);
+            bool more_space = old != nullptr, heap_full = false;
+            try
+            {
+                for (int attempt = 0; more_space && attempt < 16; ++attempt)
+                {
+                    char *to = std::allocator_traits<Allocator>::allocate(alloc, s.size);
+                    if (to < old)
+                    {
+                        std::memcpy(to, old, s.size);
+                        s.ptr.store(to, std::memory_order_release);
+                        released.emplace_back(old, s.size);
+                        ++moved;
+                        break;
+                    }
+                    released.emplace_back(to, s.size);
+
+                    // The heap grew, so there are no more free blocks of this size
+                    more_space = to < limit;
+                }
+            }
+            catch (const std::bad_alloc &)
+            {
+                // The heap is full, so nothing more can be moved
+                heap_full = true;
+            }
+            s.pins.store(0, std::memory_order_release);
+            if (heap_full)
+                break;
+        }
+
+        for (auto [p, size] : released)
+            std::allocator_traits<Allocator>::deallocate(alloc, p, size);
+        return moved;
+    }
+
+  private:
+    Allocator alloc;
+    slot *chunks[max_chunks];
+    std::uint32_t used, free_list;
+    size_type live;
+    mutable std::mutex mutex;
+
+    slot &get_slot(std::uint32_t id) const
+    {
+        --id;
+        return chunks[id / slots_per_chunk][id % slots_per_chunk];
+    }
+
+    static void wait_unpinned(slot &s)
+    {
+        std::uint32_t unpinned = 0;
+        while (!s.pins.compare_exchange_weak(unpinned, moving, std::memory_order_acquire))
+        {
+            unpinned = 0;
+            std::this_thread::yield();
+        }
+    }
+};
+
+using handle_table = basic_handle_table<>;
+} // namespace cutty::persist
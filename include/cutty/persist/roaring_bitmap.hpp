@@ -0,0 +1,720 @@
+// Implements a compressed bitmap of 32-bit integers for persistent heaps.
+
+#pragma once
+
+#include "../persist.hpp"
+#include "../sequence.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+namespace cutty::persist
+{
+/**
+    A compressed set of 32-bit unsigned integers, using the "roaring" representation.
+
+    The values are partitioned by their upper 16 bits into containers, and each container
+    stores the lower 16 bits in whichever form is smallest:
+    - an array container is a sorted array of up to 4096 values,
+    - a bitmap container is a 65536-bit bitmap,
+    - a run container is a sorted list of runs of consecutive values.
+
+    Typically this uses 2 bytes per value or less, compared with around 40 bytes per value
+    for a `std::set`. Bitmap operations work a 64-bit word at a time in loops that the
+    compiler can vectorize.
+
+    Add and remove keep array and bitmap containers up to date; call optimize() to convert
+    containers to run containers where that would be smaller.
+
+    Allocator is normally `cutty::allocator`, so the bitmap can be stored in a map_file heap,
+    but `std::allocator` also works.
+ */
+template <typename Allocator = cutty::allocator<char>> class basic_roaring_bitmap
+{
+    using u16_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<std::uint16_t>;
+    using u64_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<std::uint64_t>;
+
+    static constexpr std::size_t max_array_size = 4096;
+    static constexpr std::size_t bitmap_words = 1024;
+
+    enum class kind : std::uint8_t
+    {
+        array,
+        bitmap,
+        run
+    };
+
+    struct container
+    {
+        std::uint16_t key;
+        kind type;
+        std::uint32_t cardinality;
+
+        // For an array container, the sorted values.
+        // For a run container, pairs of (start, length-1).
+        std::vector<std::uint16_t, u16_allocator> values;
+
+        // For a bitmap container, 1024 64-bit words.
+        std::vector<std::uint64_t, u64_allocator> bits;
+
+        container(std::uint16_t key, const Allocator &alloc)
+            : key(key), type(kind::array), cardinality(0), values(alloc), bits(alloc)
+        {
+        }
+
+        bool contains(std::uint16_t low) const
+        {
+            switch (type)
+            {
+            case kind::array:
+                return std::binary_search(values.begin(), values.end(), low);
+            case kind::bitmap:
+                return bits[low >> 6] & (std::uint64_t(1) << (low & 63));
+            case kind::run:
+                for (std::size_t lo = 0, hi = values.size() / 2; lo < hi;)
+                {
+                    std::size_t mid = (lo + hi) / 2;
+                    if (low < values[2 * mid])
+                        hi = mid;
+                    else if (low > values[2 * mid] + values[2 * mid + 1])
+                        lo = mid + 1;
+                    else
+                        return true;
+                }
+                return false;
+            }
+            return false;
+        }
+
+        void to_bitmap()
+        {
+            if (type == kind::bitmap)
+                return;
+
+            bits.assign(bitmap_words, 0);
+            if (type == kind::array)
+            {
+                for (auto v : values)
+                    bits[v >> 6] |= std::uint64_t(1) << (v & 63);
+            }
+            else
+            {
+                for (std::size_t r = 0; r < values.size(); r += 2)
+                    for (std::uint32_t v = values[r], end = v + values[r + 1]; v <= end; ++v)
+                        bits[v >> 6] |= std::uint64_t(1) << (v & 63);
+            }
+            type = kind::bitmap;
+            values.clear();
+            values.shrink_to_fit();
+        }
+
+        void to_array()
+        {
+            if (type == kind::array)
+                return;
+
+            std::vector<std::uint16_t, u16_allocator> result(values.get_allocator());
+            result.reserve(cardinality);
+            if (type == kind::bitmap)
+            {
+                for (std::size_t w = 0; w < bitmap_words; ++w)
+                    for (auto word = bits[w]; word; word &= word - 1)
+                        result.push_back(std::uint16_t(w * 64 + std::countr_zero(word)));
+                bits.clear();
+                bits.shrink_to_fit();
+            }
+            else
+            {
+                for (std::size_t r = 0; r < values.size(); r += 2)
+                    for (std::uint32_t v = values[r], end = v + values[r + 1]; v <= end; ++v)
+                        result.push_back(std::uint16_t(v));
+            }
+            values = std::move(result);
+            type = kind::array;
+        }
+
+        // Converts to the best container for updates, which is an array or a bitmap
+        void to_mutable()
+        {
+            if (type == kind::run)
+            {
+                if (cardinality > max_array_size)
+                    to_bitmap();
+                else
+                    to_array();
+            }
+        }
+
+        // Converts an array or bitmap to the smallest representation of the two
+        void normalize()
+        {
+            if (type == kind::array && cardinality > max_array_size)
+                to_bitmap();
+            else if (type == kind::bitmap && cardinality <= max_array_size)
+                to_array();
+        }
+
+        std::size_t count_runs() const
+        {
+            std::size_t runs = 0;
+            switch (type)
+            {
+            case kind::array:
+                for (std::size_t i = 0; i < values.size(); ++i)
+                    runs += i == 0 || values[i] != values[i - 1] + 1;
+                break;
+            case kind::bitmap:
+                for (std::size_t w = 0; w < bitmap_words; ++w)
+                {
+                    // Count the 0->1 transitions, carrying in the top bit of the previous word
+                    std::uint64_t prev = w ? bits[w - 1] >> 63 : 0;
+                    runs += std::popcount(bits[w] & ~((bits[w] << 1) | prev));
+                }
+                break;
+            case kind::run:
+                runs = values.size() / 2;
+                break;
+            }
+            return runs;
+        }
+
+        void to_run()
+        {
+            std::vector<std::uint16_t, u16_allocator> runs(values.get_allocator());
+            runs.reserve(2 * count_runs());
+            bool in_run = false;
+            std::uint32_t start = 0, prev = 0;
+
+            auto add = [&](std::uint32_t v) {
+                if (in_run && v == prev + 1)
+                {
+                    prev = v;
+                    return;
+                }
+                if (in_run)
+                {
+                    runs.push_back(std::uint16_t(start));
+                    runs.push_back(std::uint16_t(prev - start));
+                }
+                in_run = true;
+                start = prev = v;
+            };
+
+            if (type == kind::array)
+            {
+                for (auto v : values)
+                    add(v);
+            }
+            else
+            {
+                for (std::size_t w = 0; w < bitmap_words; ++w)
+                    for (auto word = bits[w]; word; word &= word - 1)
+                        add(std::uint32_t(w * 64 + std::countr_zero(word)));
+            }
+
+            if (in_run)
+            {
+                runs.push_back(std::uint16_t(start));
+                runs.push_back(std::uint16_t(prev - start));
+            }
+
+            bits.clear();
+            bits.shrink_to_fit();
+            values = std::move(runs);
+            type = kind::run;
+        }
+
+        std::size_t size_in_bytes() const
+        {
+            return sizeof(container) + values.capacity() * sizeof(std::uint16_t) +
+                   bits.capacity() * sizeof(std::uint64_t);
+        }
+    };
+
+    using container_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<container>;
+    using container_vector = std::vector<container, container_allocator>;
+
+  public:
+    typedef std::uint32_t value_type;
+    typedef std::size_t size_type;
+    typedef Allocator allocator_type;
+
+    basic_roaring_bitmap(const Allocator &alloc = Allocator()) : containers(alloc)
+    {
+    }
+
+    allocator_type get_allocator() const
+    {
+        return containers.get_allocator();
+    }
+
+    /** Returns true if the value was added, or false if it was already present */
+    bool add(std::uint32_t value)
+    {
+        auto &c = get_or_create(value >> 16);
+        std::uint16_t low = value & 0xffff;
+        c.to_mutable();
+
+        if (c.type == kind::bitmap)
+        {
+            auto &word = c.bits[low >> 6];
+            auto bit = std::uint64_t(1) << (low & 63);
+            if (word & bit)
+                return false;
+            word |= bit;
+        }
+        else
+        {
+            auto i = std::lower_bound(c.values.begin(), c.values.end(), low);
+            if (i != c.values.end() && *i == low)
+                return false;
+            c.values.insert(i, low);
+        }
+        ++c.cardinality;
+        c.normalize();
+        return true;
+    }
+
+    /** Returns true if the value was removed, or false if it was not present */
+    bool remove(std::uint32_t value)
+    {
+        auto i = find(value >> 16);
+        if (i == containers.end())
+            return false;
+
+        auto &c = *i;
+        std::uint16_t low = value & 0xffff;
+        if (!c.contains(low))
+            return false;
+
+        c.to_mutable();
+        if (c.type == kind::bitmap)
+            c.bits[low >> 6] &= ~(std::uint64_t(1) << (low & 63));
+        else
+            c.values.erase(std::lower_bound(c.values.begin(), c.values.end(), low));
+
+        if (--c.cardinality == 0)
+            containers.erase(i);
+        else
+            c.normalize();
+        return true;
+    }
+
+    bool contains(std::uint32_t value) const
+    {
+        auto i = find(value >> 16);
+        return i != containers.end() && i->contains(value & 0xffff);
+    }
+
+    /** Returns the number of values in the set */
+    size_type cardinality() const
+    {
+        size_type result = 0;
+        for (auto &c : containers)
+            result += c.cardinality;
+        return result;
+    }
+
+    size_type size() const
+    {
+        return cardinality();
+    }
+
+    bool empty() const
+    {
+        return containers.empty();
+    }
+
+    void clear()
+    {
+        containers.clear();
+    }
+
+    /** Converts containers to run containers wherever that uses less memory */
+    void optimize()
+    {
+        for (auto &c : containers)
+        {
+            auto run_size = 4 * c.count_runs();
+            auto current_size = c.type == kind::array ? 2 * c.cardinality : 2 * max_array_size;
+            if (c.type != kind::run && run_size < current_size)
+                c.to_run();
+            else if (c.type == kind::run && run_size >= 2 * std::min<std::size_t>(c.cardinality, max_array_size))
+            {
+                c.to_mutable();
+            }
+        }
+    }
+
+    /** Returns the approximate memory used by the bitmap */
+    size_type size_in_bytes() const
+    {
+        size_type result = sizeof(*this);
+        for (auto &c : containers)
+            result += c.size_in_bytes();
+        return result;
+    }
+
+    /** Returns the number of values in both bitmaps, without constructing the intersection */
+    size_type intersection_cardinality(const basic_roaring_bitmap &other) const
+    {
+        size_type result = 0;
+        for_each_pair(other, [&](const container &a, const container &b) {
+            materialized x(a), y(b);
+            if (x.type == kind::bitmap && y.type == kind::bitmap)
+            {
+                for (std::size_t w = 0; w < bitmap_words; ++w)
+                    result += std::popcount(x.bits[w] & y.bits[w]);
+            }
+            else if (x.type == kind::array && y.type == kind::array)
+                result += intersect_arrays(x.values, y.values, [](std::uint16_t) {});
+            else
+            {
+                auto &array = x.type == kind::array ? x : y;
+                for (auto v : array.values)
+                    result += (x.type == kind::array ? y : x).contains(v);
+            }
+        });
+        return result;
+    }
+
+    /** Intersection */
+    basic_roaring_bitmap operator&(const basic_roaring_bitmap &other) const
+    {
+        basic_roaring_bitmap result(get_allocator());
+        for_each_pair(other, [&](const container &a, const container &b) {
+            materialized x(a), y(b);
+            container c(a.key, get_allocator());
+
+            if (x.type == kind::bitmap && y.type == kind::bitmap)
+            {
+                c.type = kind::bitmap;
+                c.bits.resize(bitmap_words);
+                std::uint32_t cardinality = 0;
+                for (std::size_t w = 0; w < bitmap_words; ++w)
+                {
+                    c.bits[w] = x.bits[w] & y.bits[w];
+                    cardinality += std::popcount(c.bits[w]);
+                }
+                c.cardinality = cardinality;
+            }
+            else if (x.type == kind::array && y.type == kind::array)
+            {
+                c.values.reserve(std::min(x.values.size(), y.values.size()));
+                c.cardinality = intersect_arrays(x.values, y.values, [&](std::uint16_t v) { c.values.push_back(v); });
+            }
+            else
+            {
+                auto &array = x.type == kind::array ? x : y;
+                auto &bitmap = x.type == kind::array ? y : x;
+                for (auto v : array.values)
+                    if (bitmap.contains(v))
+                        c.values.push_back(v);
+                c.cardinality = c.values.size();
+            }
+
+            if (c.cardinality)
+            {
+                c.normalize();
+                result.containers.push_back(std::move(c));
+            }
+        });
+        return result;
+    }
+
+    /** Union */
+    basic_roaring_bitmap operator|(const basic_roaring_bitmap &other) const
+    {
+        basic_roaring_bitmap result(get_allocator());
+        result.containers.reserve(containers.size() + other.containers.size());
+
+        auto i = containers.begin(), j = other.containers.begin();
+        while (i != containers.end() || j != other.containers.end())
+        {
+            if (j == other.containers.end() || (i != containers.end() && i->key < j->key))
+                result.containers.push_back(*i++);
+            else if (i == containers.end() || j->key < i->key)
+                result.containers.push_back(*j++);
+            else
+            {
+                result.containers.push_back(union_containers(*i++, *j++));
+            }
+        }
+        return result;
+    }
+
+    basic_roaring_bitmap &operator&=(const basic_roaring_bitmap &other)
+    {
+        return *this = *this & other;
+    }
+
+    basic_roaring_bitmap &operator|=(const basic_roaring_bitmap &other)
+    {
+        return *this = *this | other;
+    }
+
+    bool operator==(const basic_roaring_bitmap &other) const
+    {
+        return cardinality() == other.cardinality() && intersection_cardinality(other) == cardinality();
+    }
+
+    // A sequence of the values in the bitmap, in ascending order
+    class value_sequence : public sequences::base_sequence<std::uint32_t, value_sequence>
+    {
+        const container *containers;
+        std::size_t count, index, pos;
+        std::uint32_t offset;
+        std::uint64_t word;
+        std::uint32_t current;
+
+        // Positions on the first value at or after containers[index]
+        const std::uint32_t *seek()
+        {
+            for (; index < count; ++index)
+            {
+                auto &c = containers[index];
+                pos = 0;
+                offset = 0;
+                if (c.type == kind::bitmap)
+                {
+                    word = c.bits[0];
+                    if (scan_bitmap(c))
+                        return &current;
+                }
+                else if (!c.values.empty())
+                {
+                    current = std::uint32_t(c.key) << 16 | c.values[0];
+                    return &current;
+                }
+            }
+            return nullptr;
+        }
+
+        bool scan_bitmap(const container &c)
+        {
+            for (;;)
+            {
+                if (word)
+                {
+                    current = std::uint32_t(c.key) << 16 | std::uint32_t(pos * 64 + std::countr_zero(word));
+                    word &= word - 1;
+                    return true;
+                }
+                if (++pos == bitmap_words)
+                    return false;
+                word = c.bits[pos];
+            }
+        }
+
+      public:
+        typedef std::uint32_t value_type;
+
+        value_sequence(const container *containers, std::size_t count) : containers(containers), count(count)
+        {
+        }
+
+        const std::uint32_t *first()
+        {
+            index = 0;
+            return seek();
+        }
+
+        const std::uint32_t *next()
+        {
+            auto &c = containers[index];
+            switch (c.type)
+            {
+            case kind::array:
+                if (++pos < c.values.size())
+                {
+                    current = std::uint32_t(c.key) << 16 | c.values[pos];
+                    return &current;
+                }
+                break;
+            case kind::bitmap:
+                if (scan_bitmap(c))
+                    return &current;
+                break;
+            case kind::run:
+                if (offset < c.values[2 * pos + 1])
+                    ++offset;
+                else if (2 * ++pos < c.values.size())
+                    offset = 0;
+                else
+                    break;
+                current = std::uint32_t(c.key) << 16 | std::uint32_t(c.values[2 * pos] + offset);
+                return &current;
+            }
+            ++index;
+            return seek();
+        }
+
+        std::size_t size() const
+        {
+            std::size_t result = 0;
+            for (std::size_t i = 0; i < count; ++i)
+                result += containers[i].cardinality;
+            return result;
+        }
+    };
+
+    /** Returns the values in ascending order */
+    value_sequence values() const
+    {
+        return {containers.data(), containers.size()};
+    }
+
+  private:
+    container_vector containers;
+
+    typename container_vector::const_iterator find(std::uint16_t key) const
+    {
+        auto i = std::lower_bound(containers.begin(), containers.end(), key,
+                                  [](const container &c, std::uint16_t k) { return c.key < k; });
+        return i != containers.end() && i->key == key ? i : containers.end();
+    }
+
+    typename container_vector::iterator find(std::uint16_t key)
+    {
+        auto i = std::lower_bound(containers.begin(), containers.end(), key,
+                                  [](const container &c, std::uint16_t k) { return c.key < k; });
+        return i != containers.end() && i->key == key ? i : containers.end();
+    }
+
+    container &get_or_create(std::uint16_t key)
+    {
+        auto i = std::lower_bound(containers.begin(), containers.end(), key,
+                                  [](const container &c, std::uint16_t k) { return c.key < k; });
+        if (i == containers.end() || i->key != key)
+            i = containers.insert(i, container(key, get_allocator()));
+        return *i;
+    }
+
+    // Calls fn on each pair of containers with the same key
+    template <typename Fn> void for_each_pair(const basic_roaring_bitmap &other, Fn fn) const
+    {
+        auto i = containers.begin(), j = other.containers.begin();
+        while (i != containers.end() && j != other.containers.end())
+        {
+            if (i->key < j->key)
+                ++i;
+            else if (j->key < i->key)
+                ++j;
+            else
+                fn(*i++, *j++);
+        }
+    }
+
+    // A read-only view of a container as an array or bitmap, expanding a run container into temporaries.
+    // The temporaries use std::allocator, so queries do not allocate in the bitmap's heap.
+    struct materialized
+    {
+        kind type;
+        std::span<const std::uint16_t> values;
+        std::span<const std::uint64_t> bits;
+        std::vector<std::uint16_t> temp_values;
+        std::vector<std::uint64_t> temp_bits;
+
+        materialized(const container &c) : type(c.type), values(c.values), bits(c.bits)
+        {
+            if (type != kind::run)
+                return;
+
+            // The same representation as container::to_mutable()
+            if (c.cardinality > max_array_size)
+            {
+                temp_bits.assign(bitmap_words, 0);
+                for (std::size_t r = 0; r < c.values.size(); r += 2)
+                    for (std::uint32_t v = c.values[r], end = v + c.values[r + 1]; v <= end; ++v)
+                        temp_bits[v >> 6] |= std::uint64_t(1) << (v & 63);
+                type = kind::bitmap;
+                bits = temp_bits;
+            }
+            else
+            {
+                temp_values.reserve(c.cardinality);
+                for (std::size_t r = 0; r < c.values.size(); r += 2)
+                    for (std::uint32_t v = c.values[r], end = v + c.values[r + 1]; v <= end; ++v)
+                        temp_values.push_back(std::uint16_t(v));
+                type = kind::array;
+                values = temp_values;
+            }
+        }
+
+        materialized(const materialized &) = delete;
+        materialized &operator=(const materialized &) = delete;
+
+        bool contains(std::uint16_t low) const
+        {
+            if (type == kind::array)
+                return std::binary_search(values.begin(), values.end(), low);
+            return bits[low >> 6] & (std::uint64_t(1) << (low & 63));
+        }
+    };
+
+    template <typename V1, typename V2, typename Fn> static std::uint32_t intersect_arrays(const V1 &a, const V2 &b, Fn fn)
+    {
+        std::uint32_t count = 0;
+        for (auto i = a.begin(), j = b.begin(); i != a.end() && j != b.end();)
+        {
+            if (*i < *j)
+                ++i;
+            else if (*j < *i)
+                ++j;
+            else
+            {
+                fn(*i);
+                ++count;
+                ++i;
+                ++j;
+            }
+        }
+        return count;
+    }
+
+    container union_containers(const container &a, const container &b) const
+    {
+        materialized x(a), y(b);
+        container c(a.key, get_allocator());
+
+        if (x.type == kind::array && y.type == kind::array)
+        {
+            c.values.resize(x.values.size() + y.values.size());
+            auto end = std::set_union(x.values.begin(), x.values.end(), y.values.begin(), y.values.end(),
+                                      c.values.begin());
+            c.values.erase(end, c.values.end());
+            c.cardinality = c.values.size();
+            c.normalize();
+        }
+        else
+        {
+            c.type = kind::bitmap;
+            c.bits.assign(bitmap_words, 0);
+            for (auto *src : {&x, &y})
+            {
+                if (src->type == kind::bitmap)
+                {
+                    for (std::size_t w = 0; w < bitmap_words; ++w)
+                        c.bits[w] |= src->bits[w];
+                }
+                else
+                {
+                    for (auto v : src->values)
+                        c.bits[v >> 6] |= std::uint64_t(1) << (v & 63);
+                }
+            }
+            std::uint32_t cardinality = 0;
+            for (std::size_t w = 0; w < bitmap_words; ++w)
+                cardinality += std::popcount(c.bits[w]);
+            c.cardinality = cardinality;
+        }
+        return c;
+    }
+};
+
+using roaring_bitmap = basic_roaring_bitmap<>;
+} // namespace cutty::persist
@@ -0,0 +1,165 @@
+// Implements a heap that is spread over several map_files.
+
+#pragma once
+
+#include "../persist.hpp"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace cutty::persist
+{
+/**
+    A heap that spans several segment files, each of which is a map_file.
+
+    Each segment has its own allocator state and growth lock, so threads allocating in
+    different segments do not contend, and segments can be placed on different disks.
+    Each thread is assigned an allocation domain, which selects the segment that its
+    allocations come from.
+
+    Segments are mapped at fixed addresses, `stride` bytes apart, so pointers between
+    segments remain valid when the heap is reopened. The root object lives in segment 0.
+ */
+class sharded_map_file
+{
+  public:
+    static constexpr size_t default_stride = size_t(1) << 36;
+
+    sharded_map_file();
+
+    /**
+        Opens or creates a heap with one segment per filename.
+        The length and limit apply to each segment, and limit must not exceed stride.
+        Throws InvalidVersion if any segment has the wrong version.
+     */
+    sharded_map_file(const std::vector<std::string> &filenames, int applicationId, short majorVersion,
+                     short minorVersion, size_t length = 16384, size_t limit = 1000000, int flags = 0,
+                     size_t base = detail::default_map_address, size_t stride = default_stride);
+
+    void open(const std::vector<std::string> &filenames, int applicationId, short majorVersion, short minorVersion,
+              size_t length = 16384, size_t limit = 1000000, int flags = 0,
+              size_t base = detail::default_map_address, size_t stride = default_stride);
+
+    void close();
+
+    /** Returns the filenames `prefix.0` ... `prefix.(count-1)` */
+    static std::vector<std::string> segment_names(const std::string &prefix, int count);
+
+    // Returns true if the heap is valid and usable
+    explicit operator bool() const;
+
+    size_t segment_count() const
+    {
+        return segments.size();
+    }
+
+    map_file &segment(size_t index)
+    {
+        return *segments[index];
+    }
+
+    /** The segment containing the root object, for use with map_data */
+    map_file &root_segment()
+    {
+        return segment(0);
+    }
+
+    /** Returns true if no objects have been allocated in segment 0 */
+    bool empty() const
+    {
+        return segments[0]->empty();
+    }
+
+    void *root()
+    {
+        return segments[0]->root();
+    }
+
+    /** Returns the allocation domain of the current thread */
+    static unsigned thread_domain();
+
+    /** Sets the allocation domain of the current thread */
+    static void thread_domain(unsigned domain);
+
+    /** Returns the segment used by the current thread */
+    map_file &local_segment()
+    {
+        return segment(thread_domain() % segments.size());
+    }
+
+    /** Allocates from the current thread's segment, or returns nullptr if full */
+    void *malloc(size_t size)
+    {
+        return local_segment().malloc(size);
+    }
+
+    /** Allocates from the segment of the given domain, or returns nullptr if full */
+    void *malloc(unsigned domain, size_t size)
+    {
+        return segment(domain % segments.size()).malloc(size);
+    }
+
+    /** Frees memory allocated from any segment */
+    void free(void *p, size_t size);
+
+    /** Returns the index of the segment containing p, or -1 if not in this heap */
+    int segment_of(const void *p) const;
+
+    /** The total remaining capacity of all segments */
+    size_t capacity() const;
+
+  private:
+    std::vector<std::unique_ptr<map_file>> segments;
+};
+
+// An allocator which allocates from the current thread's segment of a sharded_map_file.
+template <class T> class sharded_allocator : public std::allocator<T>
+{
+  public:
+    sharded_allocator(sharded_map_file &map) : map(map)
+    {
+    }
+
+    // Construct from another allocator
+    template <class O> sharded_allocator(const sharded_allocator<O> &o) : map(o.map)
+    {
+    }
+
+    typedef T value_type;
+    typedef T *pointer;
+    typedef typename std::allocator<T>::size_type size_type;
+
+    typedef std::false_type propagate_on_container_copy_assignment;
+    typedef std::false_type propagate_on_container_move_assignment;
+    typedef std::false_type propagate_on_container_swap;
+
+    // Allocators for different heaps cannot free each other's memory
+    typedef std::false_type is_always_equal;
+
+    template <class O> bool operator==(const sharded_allocator<O> &other) const
+    {
+        return &map == &other.map;
+    }
+
+    pointer allocate(size_type n)
+    {
+        pointer p = static_cast<pointer>(map.malloc(n * sizeof(T)));
+        if (!p)
+            throw std::bad_alloc();
+        return p;
+    }
+
+    void deallocate(pointer p, size_type count)
+    {
+        map.free(p, count * sizeof(T));
+    }
+
+    template <class Other> struct rebind
+    {
+        typedef sharded_allocator<Other> other;
+    };
+
+    sharded_map_file &map;
+};
+} // namespace cutty::persist
@@ -0,0 +1,252 @@
+// Implements a deduplicating string pool for persistent heaps.
+
+#pragma once
+
+#include "../persist.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string_view>
+
+namespace cutty::persist
+{
+/**
+    A compact reference to a string stored in a string_pool.
+
+    Two handles from the same pool are equal if and only if their strings are equal,
+    so comparing and hashing handles is O(1). The default-constructed handle is null.
+ */
+class string_handle
+{
+  public:
+    string_handle() : value(0)
+    {
+    }
+
+    explicit string_handle(std::uint32_t value) : value(value)
+    {
+    }
+
+    /** Returns the raw value of the handle */
+    std::uint32_t id() const
+    {
+        return value;
+    }
+
+    /** Returns true if this is not the null handle */
+    explicit operator bool() const
+    {
+        return value != 0;
+    }
+
+    bool operator==(const string_handle &) const = default;
+    auto operator<=>(const string_handle &) const = default;
+
+  private:
+    std::uint32_t value;
+};
+
+/**
+    A pool of unique strings, with an open-addressed hash index.
+
+    Each distinct string is stored once, and is referred to by a 32-bit string_handle.
+    A handle is the offset of the string from the pool itself, so handles remain valid
+    in every process that maps the heap, and resolving a handle to a string is O(1).
+
+    The pool is normally stored in a map_file heap. Interning and lookup are mutexed;
+    get() does not need to lock since strings are never moved or removed.
+ */
+template <typename Allocator = cutty::allocator<char>> class basic_string_pool
+{
+    // Each string is stored in a single block containing its hash and length.
+    struct record
+    {
+        std::uint32_t hash;
+        std::uint32_t length;
+        char data[1];
+    };
+
+    using slot_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<std::uint32_t>;
+
+    // Records are at least 4-byte aligned, which gives handles a range of +/- 8GB.
+    static constexpr std::ptrdiff_t granularity = 4;
+
+  public:
+    typedef std::size_t size_type;
+
+    basic_string_pool(const Allocator &alloc = Allocator()) : alloc(alloc), slots(nullptr), capacity(0), count(0)
+    {
+    }
+
+    basic_string_pool(const basic_string_pool &) = delete;
+    basic_string_pool &operator=(const basic_string_pool &) = delete;
+
+    ~basic_string_pool()
+    {
+        slot_allocator sa(alloc);
+        for (size_type i = 0; i < capacity; ++i)
+        {
+            if (slots[i])
+            {
+                auto r = get_record(string_handle(slots[i]));
+                std::allocator_traits<Allocator>::deallocate(alloc, (char *)r, record_size(r->length));
+            }
+        }
+        if (slots)
+            std::allocator_traits<slot_allocator>::deallocate(sa, slots, capacity);
+    }
+
+    /** Returns the number of distinct strings in the pool */
+    size_type size() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return count;
+    }
+
+    /**
+        Returns the handle for the given string, adding it to the pool if necessary.
+        Throws std::bad_alloc if the heap is full, or std::length_error if the string
+        is allocated too far from the pool for its handle to represent.
+     */
+    string_handle intern(std::string_view str)
+    {
+        auto h = hash(str);
+        std::lock_guard<std::mutex> lock(mutex);
+
+        if (auto slot = find_slot(str, h); slot && *slot)
+            return string_handle(*slot);
+
+        if ((count + 1) * 4 > capacity * 3)
+            rehash(capacity ? capacity * 2 : 64);
+
+        auto r = (record *)std::allocator_traits<Allocator>::allocate(alloc, record_size(str.size()));
+
+        // Handles are 32-bit signed offsets from the pool, as decoded by get_record()
+        auto offset = ((char *)r - (char *)this) / granularity;
+        if (offset < std::numeric_limits<std::int32_t>::min() || offset > std::numeric_limits<std::int32_t>::max())
+        {
+            std::allocator_traits<Allocator>::deallocate(alloc, (char *)r, record_size(str.size()));
+            throw std::length_error("string_pool record is too far from the pool");
+        }
+
+        r->hash = h;
+        r->length = str.size();
+        std::memcpy(r->data, str.data(), str.size());
+        r->data[str.size()] = 0;
+
+        string_handle result{std::uint32_t(std::int32_t(offset))};
+        *find_slot(str, h) = result.id();
+        ++count;
+        return result;
+    }
+
+    /** Returns the handle for the given string, or a null handle if it is not in the pool */
+    string_handle find(std::string_view str) const
+    {
+        auto h = hash(str);
+        std::lock_guard<std::mutex> lock(mutex);
+        auto slot = find_slot(str, h);
+        return slot ? string_handle(*slot) : string_handle();
+    }
+
+    /** Returns the string for a handle, which must be non-null and from this pool */
+    std::string_view get(string_handle handle) const
+    {
+        auto r = get_record(handle);
+        return {r->data, r->length};
+    }
+
+    std::string_view operator[](string_handle handle) const
+    {
+        return get(handle);
+    }
+
+    /** Returns the zero-terminated string for a handle */
+    const char *c_str(string_handle handle) const
+    {
+        return get_record(handle)->data;
+    }
+
+  private:
+    Allocator alloc;
+    std::uint32_t *slots;
+    size_type capacity, count;
+    mutable std::mutex mutex;
+
+    static size_type record_size(size_type length)
+    {
+        return offsetof(record, data) + length + 1;
+    }
+
+    // FNV-1a, which gives the same result in every process that opens the heap.
+    static std::uint32_t hash(std::string_view str)
+    {
+        std::uint32_t h = 2166136261u;
+        for (unsigned char ch : str)
+            h = (h ^ ch) * 16777619u;
+        return h;
+    }
+
+    const record *get_record(string_handle handle) const
+    {
+        return (const record *)((const char *)this + std::ptrdiff_t(std::int32_t(handle.id())) * granularity);
+    }
+
+    // Finds the slot containing the string, or the empty slot where it would be inserted.
+    // Returns nullptr if the index is empty.
+    std::uint32_t *find_slot(std::string_view str, std::uint32_t h) const
+    {
+        if (!capacity)
+            return nullptr;
+
+        for (size_type i = h & (capacity - 1);; i = (i + 1) & (capacity - 1))
+        {
+            if (!slots[i])
+                return &slots[i];
+            auto r = get_record(string_handle(slots[i]));
+            if (r->hash == h && std::string_view(r->data, r->length) == str)
+                return &slots[i];
+        }
+    }
+
+    void rehash(size_type new_capacity)
+    {
+        slot_allocator sa(alloc);
+        auto new_slots = std::allocator_traits<slot_allocator>::allocate(sa, new_capacity);
+        std::fill_n(new_slots, new_capacity, 0);
+
+        for (size_type i = 0; i < capacity; ++i)
+        {
+            if (slots[i])
+            {
+                size_type j = get_record(string_handle(slots[i]))->hash & (new_capacity - 1);
+                while (new_slots[j])
+                    j = (j + 1) & (new_capacity - 1);
+                new_slots[j] = slots[i];
+            }
+        }
+
+        if (slots)
+            std::allocator_traits<slot_allocator>::deallocate(sa, slots, capacity);
+        slots = new_slots;
+        capacity = new_capacity;
+    }
+};
+
+using string_pool = basic_string_pool<>;
+} // namespace cutty::persist
+
+template <> struct std::hash<cutty::persist::string_handle>
+{
+    std::size_t operator()(cutty::persist::string_handle handle) const
+    {
+        return std::hash<std::uint32_t>()(handle.id());
+    }
+};
@@ -0,0 +1,155 @@
+#pragma once
+
+#include "shared_memory.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace cutty
+{
+/**
+    A value published by one writer to any number of readers, in shared memory.
+
+    The value is protected by a seqlock rather than a mutex, so readers never block the writer,
+    and the writer never blocks. The writer writes the buffer that readers are not currently
+    reading, then switches readers to it. Readers copy the current buffer, and retry in the
+    rare case that it was overwritten while being copied.
+
+    There must only be one writer at a time. T must be trivially copyable.
+ */
+template <typename T> class published
+{
+    static_assert(std::is_trivially_copyable_v<T>, "Published values must be trivially copyable");
+
+    struct buffer
+    {
+        alignas(64) std::atomic<std::uint64_t> sequence; // Odd while being written
+        T value;
+    };
+
+    struct layout
+    {
+        std::atomic<std::uint32_t> magic;
+        std::atomic<std::uint64_t> version; // The current buffer is version % 2
+        buffer buffers[2];
+    };
+
+    static constexpr std::uint32_t layout_magic = 0x70756231;
+
+  public:
+    /** Creates an empty published */
+    published() : m_layout(nullptr)
+    {
+    }
+
+    /**
+        Opens or creates a published value in a file.
+        A new value is zero-initialized.
+     */
+    published(const char *filename, std::error_code &ec, int flags = shared_memory::create)
+        : m_memory(filename, ec, flags, sizeof(layout)), m_layout(nullptr)
+    {
+        open(ec);
+    }
+
+    /**
+        Opens or creates a published value in shared memory, for example anonymous memory
+        shared using send_fd(). The memory is resized if it is too small.
+     */
+    published(shared_memory &&memory, std::error_code &ec) : m_memory(std::move(memory)), m_layout(nullptr)
+    {
+        open(ec);
+    }
+
+    published(const published &) = delete;
+    published &operator=(const published &) = delete;
+
+    /** Returns if the value is open */
+    explicit operator bool() const
+    {
+        return m_layout;
+    }
+
+    /** The number of times the value has been published */
+    std::uint64_t version() const
+    {
+        return m_layout->version.load(std::memory_order_acquire);
+    }
+
+    /** Publishes a new value. Only one thread may publish at a time. */
+    void publish(const T &value)
+    {
+        auto next = m_layout->version.load(std::memory_order_relaxed) + 1;
+        auto &b = m_layout->buffers[next % 2];
+        auto sequence = b.sequence.load(std::memory_order_relaxed);
+
+        b.sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        std::memcpy((void *)&b.value, &value, sizeof(T));
+        b.sequence.store(sequence + 2, std::memory_order_release);
+
+        m_layout->version.store(next, std::memory_order_release);
+    }
+
+    /** Modifies a copy of the current value, then publishes it. Only one thread may publish at a time. */
+    template <typename Fn> void update(Fn fn)
+    {
+        T value = read();
+        fn(value);
+        publish(value);
+    }
+
+    /**
+        Attempts to read the current value, without retrying.
+        Returns false if the value was being overwritten.
+     */
+    bool try_read(T &result) const
+    {
+        auto version = m_layout->version.load(std::memory_order_acquire);
+        auto &b = m_layout->buffers[version % 2];
+
+        auto before = b.sequence.load(std::memory_order_acquire);
+        if (before & 1)
+            return false;
+        std::memcpy((void *)&result, (const void *)&b.value, sizeof(T));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return b.sequence.load(std::memory_order_relaxed) == before;
+    }
+
+    /** Reads the current value, retrying until a consistent copy is read */
+    T read() const
+    {
+        T result;
+        while (!try_read(result))
+            ;
+        return result;
+    }
+
+  private:
+    shared_memory m_memory;
+    layout *m_layout;
+
+    void open(std::error_code &ec)
+    {
+        if (!m_memory)
+            return;
+        if (m_memory.size() < sizeof(layout))
+        {
+            m_memory.resize(ec, sizeof(layout));
+            if (ec || !m_memory)
+                return;
+        }
+
+        auto l = (layout *)m_memory.data();
+        if (l->magic.load(std::memory_order_acquire) != layout_magic)
+        {
+            // A new value, which is zero-initialized by the file
+            l->version.store(0, std::memory_order_relaxed);
+            l->magic.store(layout_magic, std::memory_order_release);
+        }
+        m_layout = l;
+    }
+};
+} // namespace cutty
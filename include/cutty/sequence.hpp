@@ -3,25 +3,43 @@
 
 #pragma once
 
+#include <algorithm>
 #include <array>
+#include <charconv>
+#include <concepts>
 #include <cstring>
+#include <deque>
 #include <iterator>
+#include <limits>
+#include <memory>
+#include <optional>
 #include <ranges>
+#include <span>
 #include <stdexcept>
+#include <string>
+#include <string_view>
 #include <type_traits>
+#include <utility>
+#include <vector>
 
 #include "sequence_fwd.hpp"
 #include "sequences/fwd.hpp"
 #include "sequences/helpers.hpp"
 #include "sequences/int_iterator.hpp"
+#include "sequences/kernels.hpp"
+#include "thread_pool.hpp"
 
 #include "sequences/base_sequence.hpp"
+#include "sequences/cache_sequence.hpp"
 #include "sequences/concat_sequence.hpp"
+#include "sequences/csv_sequence.hpp"
 #include "sequences/empty_sequence.hpp"
 #include "sequences/generated_sequence.hpp"
 #include "sequences/iterator_sequence.hpp"
+#include "sequences/line_sequence.hpp"
 #include "sequences/merge_sequence.hpp"
 #include "sequences/output_sequence.hpp"
+#include "sequences/parallel_sequence.hpp"
 #include "sequences/pointer_sequence.hpp"
 #include "sequences/repeat_sequence.hpp"
 #include "sequences/select_sequence.hpp"
@@ -31,6 +49,7 @@
 #include "sequences/skip_sequence.hpp"
 #include "sequences/skip_until_sequence.hpp"
 #include "sequences/split_sequence.hpp"
+#include "sequences/split_view_sequence.hpp"
 #include "sequences/stored_sequence.hpp"
 #include "sequences/take_sequence.hpp"
 #include "sequences/take_while_sequence.hpp"
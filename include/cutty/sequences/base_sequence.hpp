@@ -41,11 +41,36 @@ template <typename T, typename Derived, typename Stored = Derived> class base_se
     size_type size() const
     {
         size_type c = 0;
-        for (auto i = self().first(); i; i = self().next())
+        self().iterate([&](const T &) {
             ++c;
+            return true;
+        });
         return c;
     }
 
+    // The number of elements, if it is known without iterating the sequence.
+    // Random access sequences know their exact size, and derived classes can override this.
+    helpers::size_hint size_hint() const
+    {
+        if constexpr (helpers::random_access_sequence<Derived>)
+            return {helpers::size_hint::exact, self().size()};
+        else
+            return {};
+    }
+
+    // Internal iteration: calls fn on each element until fn returns false.
+    // Returns false if fn stopped the iteration.
+    // Derived classes override this to push elements through the pipeline,
+    // which avoids storing intermediate values in first()/next(), and lets
+    // the compiler fuse the pipeline into a single loop.
+    template <typename Fn> bool iterate(Fn fn) const
+    {
+        for (auto i = self().first(); i; i = self().next())
+            if (!fn(*i))
+                return false;
+        return true;
+    }
+
     struct iterator
     {
         typedef T value_type;
@@ -127,32 +152,117 @@ template <typename T, typename Derived, typename Stored = Derived> class base_se
     template <typename Aggregate> T aggregate(Aggregate agg) const
     {
         T result = {};
-        for (const value_type *i = self().first(); i; i = self().next())
-            result = agg(result, *i);
+        self().iterate([&](const T &i) {
+            result = agg(result, i);
+            return true;
+        });
         return result;
     }
 
     template <typename Aggregate, typename U> U aggregate(U result, Aggregate agg) const
     {
-        for (const value_type *i = self().first(); i; i = self().next())
-            result = agg(result, *i);
+        self().iterate([&](const T &i) {
+            result = agg(result, i);
+            return true;
+        });
         return result;
     }
 
     template <typename Aggregate, typename U> U accumulate(U result, Aggregate agg) const
     {
-        for (const value_type *i = self().first(); i; i = self().next())
-            agg(result, *i);
+        self().iterate([&](const T &i) {
+            agg(result, i);
+            return true;
+        });
         return result;
     }
 
+    // Contiguous sequences of arithmetic types use precompiled vectorized kernels
     T sum() const
     {
-        return aggregate([](const T &i1, const T &i2) { return i1 + i2; });
+        if constexpr (helpers::kernel_sequence<Derived>)
+            return kernels::sum(self().data(), self().size());
+        else
+            return aggregate([](const T &i1, const T &i2) { return i1 + i2; });
+    }
+
+    // Returns the smallest element, throwing std::out_of_range if the sequence is empty
+    T min() const
+    {
+        if constexpr (helpers::kernel_sequence<Derived>)
+        {
+            if (!self().size())
+                throw std::out_of_range("min() called on an empty list");
+            return kernels::min(self().data(), self().size());
+        }
+        else
+        {
+            std::optional<T> result;
+            self().iterate([&](const T &i) {
+                if (!result || i < *result)
+                    result = i;
+                return true;
+            });
+            if (!result)
+                throw std::out_of_range("min() called on an empty list");
+            return *result;
+        }
+    }
+
+    // Returns the largest element, throwing std::out_of_range if the sequence is empty
+    T max() const
+    {
+        if constexpr (helpers::kernel_sequence<Derived>)
+        {
+            if (!self().size())
+                throw std::out_of_range("max() called on an empty list");
+            return kernels::max(self().data(), self().size());
+        }
+        else
+        {
+            std::optional<T> result;
+            self().iterate([&](const T &i) {
+                if (!result || *result < i)
+                    result = i;
+                return true;
+            });
+            if (!result)
+                throw std::out_of_range("max() called on an empty list");
+            return *result;
+        }
+    }
+
+    // Returns the sum of the products of corresponding elements, stopping at the end of the shorter sequence
+    template <typename Seq2, typename = typename Seq2::is_sequence> T dot(const Seq2 &seq2) const
+    {
+        if constexpr (helpers::kernel_sequence<Derived> && helpers::kernel_sequence<Seq2> &&
+                      std::is_same_v<T, typename Seq2::value_type>)
+            return kernels::dot(self().data(), seq2.data(), std::min<size_type>(self().size(), seq2.size()));
+        else
+        {
+            T result = {};
+            auto &other = seq2.self();
+            auto i2 = other.first();
+            self().iterate([&](const T &i) {
+                if (!i2)
+                    return false;
+                result += i * *i2;
+                i2 = other.next();
+                return true;
+            });
+            return result;
+        }
     }
 
+    // at(), back() and their defaults are O(1) for random access sequences
     const T &at(size_type index) const
     {
+        if constexpr (helpers::random_access_sequence<Derived>)
+        {
+            if (index >= self().size())
+                throw std::out_of_range("at() is out of range");
+            return self().element(index);
+        }
         for (auto c = self().first(); c; c = self().next())
         {
             if (index-- == 0)
@@ -163,6 +273,8 @@ template <typename T, typename Derived, typename Stored = Derived> class base_se
 
     value_type at_or_default(size_type index, const value_type &value) const
     {
+        if constexpr (helpers::random_access_sequence<Derived>)
+            return index < self().size() ? self().element(index) : value;
         for (auto c = self().first(); c; c = self().next())
         {
             if (index-- == 0)
@@ -181,6 +293,13 @@ template <typename T, typename Derived, typename Stored = Derived> class base_se
 
     const value_type &back() const
     {
+        if constexpr (helpers::random_access_sequence<Derived>)
+        {
+            auto size = self().size();
+            if (!size)
+                throw std::out_of_range("back() called on an empty list");
+            return self().element(size - 1);
+        }
         for (auto c = self().first(); c;)
         {
             auto c2 = self().next();
@@ -230,6 +349,11 @@ template <typename T, typename Derived, typename Stored = Derived> class base_se
     template <typename T2, typename Derived2, typename Stored2, typename Eq = std::equal_to<T>>
     bool equals(const base_sequence<T2, Derived2, Stored2> &other, Eq eq = {}) const
     {
+        if constexpr (std::is_same_v<Eq, std::equal_to<T>> && std::is_same_v<T, T2> &&
+                      helpers::kernel_sequence<Derived> && helpers::kernel_sequence<Derived2>)
+            return self().size() == other.self().size() &&
+                   kernels::equal(self().data(), other.self().data(), self().size());
+
         auto i1 = self().first();
         auto i2 = other.self().first();
 
@@ -296,7 +420,7 @@ template <typename T, typename Derived, typename Stored = Derived> class base_se
 
     template <typename Predicate> bool any(Predicate p) const
     {
-        return where(p).any();
+        return !self().iterate([&](const T &i) { return !p(i); });
     }
 
     bool empty() const
@@ -318,6 +442,11 @@ template <typename T, typename Derived, typename Stored = Derived> class base_se
     // Returns by value (not by reference) to avoid dangers of dangling references.
     value_type back_or_default(const value_type &value) const
     {
+        if constexpr (helpers::random_access_sequence<Derived>)
+        {
+            auto size = self().size();
+            return size ? self().element(size - 1) : value;
+        }
         for (auto c = self().first(); c;)
         {
             auto c2 = self().next();
@@ -328,9 +457,15 @@ template <typename T, typename Derived, typename Stored = Derived> class base_se
         return value;
     }
 
-    template <typename Predicate> size_type count(Predicate p)
+    template <typename Predicate> size_type count(Predicate p) const
     {
-        return where(p).size();
+        size_type c = 0;
+        self().iterate([&](const T &i) {
+            if (p(i))
+                ++c;
+            return true;
+        });
+        return c;
     }
 
     template <typename Seq2, typename Fn, typename = typename Seq2::is_sequence>
@@ -364,21 +499,63 @@ template <typename T, typename Derived, typename Stored = Derived> class base_se
     // Writes the sequence to the output sequence
     template <typename U> void write_to(const output_sequence<U> &out) const
     {
-        for (auto &i : *this)
+        self().iterate([&](const T &i) {
             out.push_back(i);
+            return true;
+        });
     }
 
-    // Writes the sequence to the container
+    // Writes the sequence to the container.
+    // When the size is known exactly, the container reserves space for the elements first,
+    // and contiguous sequences are inserted in a single call.
     template <typename Container> void write_to(Container &c) const
     {
-        for (auto &i : *this)
-            c.insert(c.end(), i);
+        if constexpr (helpers::contiguous_sequence<Derived> &&
+                      requires(const T *p) { c.insert(c.end(), p, p); })
+        {
+            auto p = self().data();
+            c.insert(c.end(), p, p + self().size());
+        }
+        else
+        {
+            if constexpr (requires(std::size_t n) { c.reserve(n); })
+            {
+                auto hint = self().size_hint();
+                if (hint.kind == helpers::size_hint::exact)
+                    c.reserve(c.size() + hint.value);
+            }
+            self().iterate([&](const T &i) {
+                c.insert(c.end(), i);
+                return true;
+            });
+        }
     }
 
     // Creates a container containing the elements of the sequence
-    template <typename Container> Container make()
+    template <typename Container> Container make() const
     {
-        return {begin(), end()};
+        if constexpr (requires(Container c, const T &i) { c.insert(c.end(), i); })
+        {
+            Container c;
+            write_to(c);
+            return c;
+        }
+        else
+            return {begin(), end()};
+    }
+
+    // Runs the terminal operations sum(), aggregate(), count(), any() and size() on a thread pool.
+    // The source must be splittable, with only where() and select() applied.
+    parallel_sequence<Derived> parallel(thread_pool &pool = thread_pool::default_pool()) const
+    {
+        return {self(), pool};
+    }
+
+    // Stores the elements as they are read, so that later passes do not evaluate this sequence again.
+    // When there are more than max elements, the sequence is evaluated normally.
+    cache_sequence<Stored> cache(std::size_t max = std::numeric_limits<std::size_t>::max()) const
+    {
+        return {self(), max};
     }
 
     repeat_sequence<Stored> repeat(int n) const
@@ -390,5 +567,29 @@ template <typename T, typename Derived, typename Stored = Derived> class base_se
     {
         return {self(), splitChars};
     }
+
+    // The rows of CSV text in contiguous characters, with cells separated by the delimiter
+    csv_sequence<T> csv(T delimiter = ',') const
+        requires helpers::contiguous_sequence<Derived>
+    {
+        auto p = self().data();
+        return {p, p + self().size(), delimiter};
+    }
+
+    // The lines in contiguous characters, as std::basic_string_view that refer to the original characters
+    line_sequence<T> lines() const
+        requires helpers::contiguous_sequence<Derived>
+    {
+        auto p = self().data();
+        return {p, p + self().size()};
+    }
+
+    // Splits contiguous characters into std::basic_string_view tokens that refer to the original characters
+    split_view_sequence<T> split_view(const T *splitChars) const
+        requires helpers::contiguous_sequence<Derived>
+    {
+        auto p = self().data();
+        return {p, p + self().size(), splitChars};
+    }
 };
 } // namespace cutty::sequences
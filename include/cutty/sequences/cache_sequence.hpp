@@ -0,0 +1,124 @@
+// Implements a sequence that evaluates another sequence once, and replays the stored elements on later passes.
+// The elements are stored in a chunked buffer (std::deque) as they are first read, so stored elements do not move.
+// Copies of a cache_sequence share the same buffer, which is not thread safe.
+
+namespace cutty::sequences
+{
+template <typename Seq> class cache_sequence : public base_sequence<typename Seq::value_type, cache_sequence<Seq>>
+{
+  public:
+    typedef typename Seq::value_type value_type;
+
+  private:
+    struct state
+    {
+        state(const Seq &seq, std::size_t max) : source(seq), reader(seq), max(max)
+        {
+        }
+
+        Seq source; // Never iterated, copied to evaluate the sequence again
+        Seq reader; // Fills the buffer
+        std::deque<value_type> buffer;
+        std::size_t max;
+        bool started = false, complete = false, overflowed = false;
+    };
+
+    std::shared_ptr<state> cache;
+    std::size_t position = 0;
+    std::optional<Seq> direct; // Reads past the end of the buffer when it has overflowed
+
+    // Gets element i, reading it from the source if it has not been stored yet.
+    // Elements are fetched in order, so i is never beyond the end of the buffer.
+    static const value_type *fetch(state &s, std::size_t i, std::optional<Seq> &direct)
+    {
+        if (direct)
+            return direct->next();
+        if (i < s.buffer.size())
+            return &s.buffer[i];
+        if (s.complete)
+            return nullptr;
+
+        if (!s.overflowed)
+        {
+            auto p = s.started ? s.reader.next() : s.reader.first();
+            s.started = true;
+            if (!p)
+            {
+                s.complete = true;
+                return nullptr;
+            }
+            if (s.buffer.size() < s.max)
+            {
+                s.buffer.push_back(*p);
+                return &s.buffer.back();
+            }
+            s.overflowed = true;
+        }
+
+        // The buffer is full, so this pass continues on its own copy of the source
+        auto p = direct.emplace(s.source).first();
+        for (std::size_t j = 0; p && j < i; ++j)
+            p = direct->next();
+        return p;
+    }
+
+  public:
+    cache_sequence(const Seq &seq, std::size_t max) : cache(std::make_shared<state>(seq, max))
+    {
+    }
+
+    // Once the buffer has overflowed, new passes evaluate the source directly
+    const value_type *first()
+    {
+        position = 0;
+        direct.reset();
+        if (cache->overflowed)
+            return direct.emplace(cache->source).first();
+        return fetch(*cache, 0, direct);
+    }
+
+    const value_type *next()
+    {
+        return fetch(*cache, ++position, direct);
+    }
+
+    template <typename Fn> bool iterate(Fn fn) const
+    {
+        if (cache->overflowed)
+        {
+            Seq seq = cache->source;
+            return seq.iterate(fn);
+        }
+
+        std::optional<Seq> d;
+        for (std::size_t i = 0;; ++i)
+        {
+            auto p = fetch(*cache, i, d);
+            if (!p)
+                return true;
+            if (!fn(*p))
+                return false;
+        }
+    }
+
+    std::size_t size() const
+    {
+        if (cache->complete)
+            return cache->buffer.size();
+        return base_sequence<value_type, cache_sequence<Seq>>::size();
+    }
+
+    helpers::size_hint size_hint() const
+    {
+        if (cache->complete)
+            return {helpers::size_hint::exact, cache->buffer.size()};
+        return cache->source.size_hint();
+    }
+
+    // True when the whole sequence has been read and stored
+    bool cached() const
+    {
+        return cache->complete;
+    }
+};
+} // namespace cutty::sequences
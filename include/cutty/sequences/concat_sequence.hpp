@@ -39,10 +39,27 @@ class concat_sequence : public base_sequence<typename Seq1::value_type, concat_s
         return seq2.next();
     }
 
+    template <typename Fn> bool iterate(Fn fn) const
+    {
+        return seq1.iterate(fn) && seq2.iterate(fn);
+    }
+
     // Override for a more efficient implementation
-    std::size_t size()
+    std::size_t size() const
     {
         return seq1.size() + seq2.size();
     }
+
+    helpers::size_hint size_hint() const
+    {
+        return seq1.size_hint() + seq2.size_hint();
+    }
+
+    const value_type &element(std::size_t i)
+        requires helpers::random_access_sequence<Seq1> && helpers::random_access_sequence<Seq2>
+    {
+        auto size1 = seq1.size();
+        return i < size1 ? seq1.element(i) : seq2.element(i - size1);
+    }
 };
 } // namespace cutty::sequences
\ No newline at end of file
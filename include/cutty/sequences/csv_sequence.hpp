@@ -0,0 +1,283 @@
+// Implements a sequence of the rows in CSV (comma-separated values) text, given as contiguous characters.
+// Cells are std::string_view into the original text, except for quoted cells containing "" which are unescaped.
+// Rows end with "\n", "\r\n" or "\r", and empty lines are skipped. Quoted cells can contain delimiters and newlines.
+
+namespace cutty::sequences
+{
+// A row of a CSV file
+template <typename Char> class csv_row
+{
+    friend class csv_sequence<Char>;
+
+    typedef std::basic_string_view<Char> cell_type;
+
+    std::vector<cell_type> m_cells;
+
+    // Quoted cells that contained "" are unescaped into m_unescaped
+    struct escape
+    {
+        std::size_t column, offset, length;
+    };
+
+    std::basic_string<Char> m_unescaped;
+    std::vector<escape> m_escapes;
+
+    // Points the escaped cells at the unescaped text, once it is complete
+    void fix_escapes()
+    {
+        for (auto &e : m_escapes)
+            m_cells[e.column] = {m_unescaped.data() + e.offset, e.length};
+    }
+
+  public:
+    csv_row() = default;
+
+    // Copies must refer to their own unescaped text
+    csv_row(const csv_row &other)
+        : m_cells(other.m_cells), m_unescaped(other.m_unescaped), m_escapes(other.m_escapes)
+    {
+        fix_escapes();
+    }
+
+    csv_row &operator=(const csv_row &other)
+    {
+        m_cells = other.m_cells;
+        m_unescaped = other.m_unescaped;
+        m_escapes = other.m_escapes;
+        fix_escapes();
+        return *this;
+    }
+
+    // Short unescaped text can move within the string, so moves also need fixing
+    csv_row(csv_row &&other) noexcept
+        : m_cells(std::move(other.m_cells)), m_unescaped(std::move(other.m_unescaped)),
+          m_escapes(std::move(other.m_escapes))
+    {
+        fix_escapes();
+    }
+
+    csv_row &operator=(csv_row &&other) noexcept
+    {
+        m_cells = std::move(other.m_cells);
+        m_unescaped = std::move(other.m_unescaped);
+        m_escapes = std::move(other.m_escapes);
+        fix_escapes();
+        return *this;
+    }
+
+    std::size_t size() const
+    {
+        return m_cells.size();
+    }
+
+    bool empty() const
+    {
+        return m_cells.empty();
+    }
+
+    cell_type operator[](std::size_t column) const
+    {
+        return m_cells[column];
+    }
+
+    // Gets a cell, throwing std::out_of_range if there is no such column
+    cell_type at(std::size_t column) const
+    {
+        if (column >= m_cells.size())
+            throw std::out_of_range("CSV column out of range");
+        return m_cells[column];
+    }
+
+    std::span<const cell_type> cells() const
+    {
+        return m_cells;
+    }
+
+    typename std::vector<cell_type>::const_iterator begin() const
+    {
+        return m_cells.begin();
+    }
+
+    typename std::vector<cell_type>::const_iterator end() const
+    {
+        return m_cells.end();
+    }
+
+    // Parses a cell as a number using std::from_chars, or returns an empty optional if the whole cell is not a number
+    template <typename T> std::optional<T> try_get(std::size_t column) const
+    {
+        static_assert(sizeof(Char) == 1, "numbers can only be parsed from char");
+        auto cell = at(column);
+        T value;
+        auto [ptr, ec] = std::from_chars(cell.data(), cell.data() + cell.size(), value);
+        if (ec != std::errc() || ptr != cell.data() + cell.size())
+            return {};
+        return value;
+    }
+
+    // Gets a cell as a given type. Numbers are parsed using std::from_chars,
+    // and std::invalid_argument is thrown if the cell is not a number.
+    template <typename T> T get(std::size_t column) const
+    {
+        if constexpr (std::is_same_v<T, cell_type>)
+            return at(column);
+        else if constexpr (std::is_same_v<T, std::basic_string<Char>>)
+            return T(at(column));
+        else
+        {
+            auto value = try_get<T>(column);
+            if (!value)
+                throw std::invalid_argument("CSV cell is not a number");
+            return *value;
+        }
+    }
+};
+
+template <typename Char> class csv_sequence : public base_sequence<csv_row<Char>, csv_sequence<Char>>
+{
+    const Char *a, *b, *current;
+    Char delimiter_char;
+    csv_row<Char> row;
+
+    // How characters affect an unquoted cell
+    enum char_class : unsigned char
+    {
+        ordinary,
+        delimiter,
+        end_of_line
+    };
+
+    // Characters below 256 are classified using a table
+    char_class classes[256] = {};
+
+    char_class classify(Char ch) const
+    {
+        auto u = std::make_unsigned_t<Char>(ch);
+        if constexpr (sizeof(Char) == 1)
+            return classes[u];
+        else if (u < 256)
+            return classes[u];
+        else
+            return ch == delimiter_char ? delimiter : ordinary;
+    }
+
+    void clear(csv_row<Char> &row) const
+    {
+        row.m_cells.clear();
+        row.m_unescaped.clear();
+        row.m_escapes.clear();
+    }
+
+    // Reads a quoted cell, with p just after the opening quote
+    void read_quoted(const Char *&p, csv_row<Char> &row) const
+    {
+        auto start = p;
+        bool escaped = false;
+        const Char *end;
+        for (;;)
+        {
+            auto q = std::char_traits<Char>::find(p, b - p, Char('"'));
+            if (!q)
+            {
+                // Unterminated quote, which runs to the end of the text
+                end = p = b;
+                break;
+            }
+            if (q + 1 != b && q[1] == Char('"'))
+            {
+                escaped = true;
+                p = q + 2;
+                continue;
+            }
+            end = q;
+            p = q + 1;
+            break;
+        }
+
+        if (escaped)
+        {
+            auto offset = row.m_unescaped.size();
+            for (auto i = start; i < end; ++i)
+            {
+                row.m_unescaped += *i;
+                if (*i == Char('"'))
+                    ++i;
+            }
+            row.m_escapes.push_back({row.m_cells.size(), offset, row.m_unescaped.size() - offset});
+            row.m_cells.emplace_back();
+        }
+        else
+            row.m_cells.emplace_back(start, end - start);
+
+        // Ignore anything between the closing quote and the end of the cell
+        while (p != b && classify(*p) == ordinary)
+            ++p;
+    }
+
+  public:
+    typedef csv_row<Char> value_type;
+
+    csv_sequence(const Char *a, const Char *b, Char delimiter) : a(a), b(b), delimiter_char(delimiter)
+    {
+        if (std::make_unsigned_t<Char>(delimiter) < 256)
+            classes[std::make_unsigned_t<Char>(delimiter)] = char_class::delimiter;
+        classes['\r'] = end_of_line;
+        classes['\n'] = end_of_line;
+    }
+
+    // Reads the row at or after p, and moves p to the end of the row
+    bool read(const Char *&p, value_type &result) const
+    {
+        while (p != b && classify(*p) == end_of_line)
+            ++p;
+        if (p == b)
+            return false;
+
+        clear(result);
+        for (;;)
+        {
+            if (*p == Char('"'))
+                read_quoted(++p, result);
+            else
+            {
+                auto start = p;
+                while (p != b && classify(*p) == ordinary)
+                    ++p;
+                result.m_cells.emplace_back(start, p - start);
+            }
+
+            if (p == b || classify(*p++) == end_of_line)
+                break;
+            if (p == b)
+            {
+                // A delimiter at the end of the text is followed by an empty cell
+                result.m_cells.emplace_back();
+                break;
+            }
+        }
+
+        result.fix_escapes();
+        return true;
+    }
+
+    const value_type *first()
+    {
+        current = a;
+        return next();
+    }
+
+    const value_type *next()
+    {
+        return read(current, row) ? &row : nullptr;
+    }
+
+    template <typename Fn> bool iterate(Fn fn) const
+    {
+        value_type r;
+        for (auto p = a; read(p, r);)
+            if (!fn(r))
+                return false;
+        return true;
+    }
+};
+} // namespace cutty::sequences
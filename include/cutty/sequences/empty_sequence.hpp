@@ -14,9 +14,29 @@ template <typename T> class empty_sequence : public base_sequence<T, empty_seque
     {
         return nullptr;
     }
+    template <typename Fn> bool iterate(Fn) const
+    {
+        return true;
+    }
+
     std::size_t size() const
     {
         return 0;
     }
+
+    helpers::size_hint size_hint() const
+    {
+        return {helpers::size_hint::exact, 0};
+    }
+
+    empty_sequence slice(std::size_t, std::size_t) const
+    {
+        return {};
+    }
+
+    std::size_t split_size() const
+    {
+        return 0;
+    }
 };
 } // namespace cutty::sequences
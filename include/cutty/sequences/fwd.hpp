@@ -30,5 +30,15 @@ template <typename Seq> class repeat_sequence;
 
 template <typename Seq> class split_sequence;
 
+template <typename Char> class split_view_sequence;
+
+template <typename Char> class line_sequence;
+
+template <typename Char> class csv_sequence;
+
 template <typename Container> class stored_sequence;
+
+template <typename Seq> class parallel_sequence;
+
+template <typename Seq> class cache_sequence;
 } // namespace cutty::sequences
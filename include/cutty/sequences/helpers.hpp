@@ -54,6 +54,135 @@ template <typename R, typename... Args> struct deduce_result<R (*)(Args...)>
     typedef typename remove_all<R>::type type;
 };
 
+// Fills a batch from a sequence, starting with the element 'current'
+// and calling next() for subsequent elements. Returns the number of elements copied.
+template <typename T, typename Next> std::size_t fill_batch(const T *current, std::span<T> buffer, Next next)
+{
+    if constexpr (std::is_copy_assignable_v<T>)
+    {
+        std::size_t n = 0;
+        while (current)
+        {
+            buffer[n++] = *current;
+            if (n == buffer.size())
+                break;
+            current = next();
+        }
+        return n;
+    }
+    else
+        return 0;
+}
+
+// A sequence whose elements are stored contiguously, given by data() and size()
+template <typename Seq>
+concept contiguous_sequence = requires(const Seq &s) {
+    { s.data() } -> std::same_as<const typename Seq::value_type *>;
+    { s.size() } -> std::convertible_to<std::size_t>;
+};
+
+// A sequence whose elements can be accessed by index using element(), with an O(1) size()
+template <typename Seq>
+concept random_access_sequence = requires(Seq &s, const Seq &cs, std::size_t i) {
+    { s.element(i) } -> std::convertible_to<const typename Seq::value_type &>;
+    { cs.size() } -> std::convertible_to<std::size_t>;
+};
+
+// A sequence that can be split into independent slices, for parallel execution.
+// slice(begin, end) gives the same pipeline over part of the source, which has split_size() elements.
+template <typename Seq>
+concept splittable_sequence = requires(const Seq &s, std::size_t i) {
+    s.slice(i, i);
+    { s.split_size() } -> std::convertible_to<std::size_t>;
+};
+
+// What is known about the size of a sequence without iterating it
+struct size_hint
+{
+    enum kind_type
+    {
+        unknown,
+        upper_bound,
+        exact
+    };
+
+    kind_type kind = unknown;
+    std::size_t value = 0;
+
+    // The hint after filtering, where any element might be removed
+    size_hint filtered() const
+    {
+        return {kind == exact ? upper_bound : kind, value};
+    }
+
+    // The hint when no more than n elements are taken
+    size_hint at_most(std::size_t n) const
+    {
+        return kind == unknown ? size_hint{upper_bound, n} : size_hint{kind, std::min(value, n)};
+    }
+
+    // The hint when the first n elements are removed
+    size_hint without(std::size_t n) const
+    {
+        return {kind, value > n ? value - n : 0};
+    }
+
+    size_hint operator+(const size_hint &other) const
+    {
+        if (kind == unknown || other.kind == unknown)
+            return {};
+        return {std::min(kind, other.kind), value + other.value};
+    }
+
+    size_hint operator*(std::size_t n) const
+    {
+        return {n == 0 ? exact : kind, value * n};
+    }
+};
+
+// A set of delimiter characters, given as a null-terminated string.
+// Characters below 256 are looked up in a table instead of searching the string.
+template <typename Char> class char_set
+{
+    const Char *chars;
+    bool table[256] = {};
+    std::size_t count = 0;
+
+  public:
+    char_set(const Char *chars) : chars(chars)
+    {
+        for (auto i = chars; *i; ++i, ++count)
+            if (std::make_unsigned_t<Char>(*i) < 256)
+                table[std::make_unsigned_t<Char>(*i)] = true;
+    }
+
+    bool contains(Char ch) const
+    {
+        auto u = std::make_unsigned_t<Char>(ch);
+        if constexpr (sizeof(Char) == 1)
+            return table[u];
+        else if (u < 256)
+            return table[u];
+        else
+            return std::char_traits<Char>::find(chars, count, ch);
+    }
+
+    // Finds the first character in [p, end) that is in the set, or end.
+    // A single char delimiter uses memchr, which is vectorized by the C library.
+    const Char *find(const Char *p, const Char *end) const
+    {
+        if constexpr (sizeof(Char) == 1)
+            if (count == 1)
+            {
+                auto result = std::memchr(p, chars[0], end - p);
+                return result ? static_cast<const Char *>(result) : end;
+            }
+        while (p != end && !contains(*p))
+            ++p;
+        return p;
+    }
+};
+
 // Functor to get the first element of a pair
 template <typename P> struct project_first;
 
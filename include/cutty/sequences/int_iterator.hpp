@@ -40,5 +40,10 @@ class int_iterator
     {
         return value - other.value;
     }
+
+    int_iterator operator+(int n) const
+    {
+        return value + n;
+    }
 };
 } // namespace cutty::sequences
@@ -28,10 +28,36 @@ class iterator_sequence
         return current != to ? &*current : nullptr;
     }
 
+    template <typename Fn> bool iterate(Fn fn) const
+    {
+        for (auto i = from; i != to; ++i)
+            if (!fn(*i))
+                return false;
+        return true;
+    }
+
     std::size_t size() const
     {
         return std::ranges::distance(from, to);
     }
+
+    const value_type &element(std::size_t i)
+        requires requires(It it, std::iter_difference_t<It> n) { it + n; }
+    {
+        current = from + std::iter_difference_t<It>(i);
+        return *current;
+    }
+
+    iterator_sequence<It, It> slice(std::size_t begin, std::size_t end) const
+        requires requires(It it, std::iter_difference_t<It> n) { it + n; }
+    {
+        return {from + std::iter_difference_t<It>(begin), from + std::iter_difference_t<It>(end)};
+    }
+
+    std::size_t split_size() const
+    {
+        return size();
+    }
 };
 
 // A version of iterator_sequence that stores the current value of the iterator
@@ -0,0 +1,42 @@
+// Precompiled reductions over contiguous arrays of arithmetic types.
+// These are compiled for several instruction sets (for example AVX2 and AVX-512),
+// and the best version for the CPU is selected at runtime.
+// Sums of floating point numbers are computed pairwise, which is more accurate
+// than adding each element in turn, so the result can differ slightly.
+
+namespace cutty::sequences
+{
+namespace kernels
+{
+#define CUTTY_SEQUENCE_KERNELS(T)                                                                                      \
+    T sum(const T *data, std::size_t size);                                                                            \
+    T min(const T *data, std::size_t size);                                                                            \
+    T max(const T *data, std::size_t size);                                                                            \
+    T dot(const T *a, const T *b, std::size_t size);                                                                   \
+    bool equal(const T *a, const T *b, std::size_t size);
+
+CUTTY_SEQUENCE_KERNELS(int)
+CUTTY_SEQUENCE_KERNELS(unsigned)
+CUTTY_SEQUENCE_KERNELS(long)
+CUTTY_SEQUENCE_KERNELS(unsigned long)
+CUTTY_SEQUENCE_KERNELS(long long)
+CUTTY_SEQUENCE_KERNELS(unsigned long long)
+CUTTY_SEQUENCE_KERNELS(float)
+CUTTY_SEQUENCE_KERNELS(double)
+
+#undef CUTTY_SEQUENCE_KERNELS
+
+// The element types that have kernels
+template <typename T>
+concept kernel_type = std::same_as<T, int> || std::same_as<T, unsigned> || std::same_as<T, long> ||
+                      std::same_as<T, unsigned long> || std::same_as<T, long long> ||
+                      std::same_as<T, unsigned long long> || std::same_as<T, float> || std::same_as<T, double>;
+} // namespace kernels
+
+namespace helpers
+{
+// A contiguous sequence that can use the precompiled kernels
+template <typename Seq>
+concept kernel_sequence = contiguous_sequence<Seq> && kernels::kernel_type<typename Seq::value_type>;
+} // namespace helpers
+} // namespace cutty::sequences
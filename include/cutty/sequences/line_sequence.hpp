@@ -0,0 +1,55 @@
+// Implements a sequence of the lines in contiguous characters, without copying them.
+// Lines end with '\n' or "\r\n", which are not included in the line. Empty lines are kept,
+// but there is no empty line after a final newline.
+
+namespace cutty::sequences
+{
+template <typename Char> class line_sequence : public base_sequence<std::basic_string_view<Char>, line_sequence<Char>>
+{
+    const Char *a, *b, *current;
+
+  public:
+    typedef std::basic_string_view<Char> value_type;
+
+    line_sequence(const Char *a, const Char *b) : a(a), b(b)
+    {
+    }
+
+    value_type line;
+
+    // Finds the line starting at p, and moves p to the start of the next line
+    bool find(const Char *&p, value_type &result) const
+    {
+        if (p == b)
+            return false;
+        auto end = std::char_traits<Char>::find(p, b - p, Char('\n'));
+        if (!end)
+            end = b;
+        result = {p, std::size_t(end - p)};
+        if (!result.empty() && result.back() == Char('\r'))
+            result.remove_suffix(1);
+        p = end == b ? b : end + 1;
+        return true;
+    }
+
+    const value_type *first()
+    {
+        current = a;
+        return next();
+    }
+
+    const value_type *next()
+    {
+        return find(current, line) ? &line : nullptr;
+    }
+
+    template <typename Fn> bool iterate(Fn fn) const
+    {
+        value_type l;
+        for (auto p = a; find(p, l);)
+            if (!fn(l))
+                return false;
+        return true;
+    }
+};
+} // namespace cutty::sequences
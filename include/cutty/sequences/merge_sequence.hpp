@@ -9,6 +9,9 @@ class merge_sequence : public base_sequence<typename helpers::deduce_result<Fn>:
     Seq2 seq2;
     Fn fn;
 
+    static constexpr bool random_access =
+        helpers::random_access_sequence<Seq1> && helpers::random_access_sequence<Seq2>;
+
   public:
     merge_sequence(const Seq1 &s1, const Seq2 &s2, Fn fn) : seq1(s1), seq2(s2), fn(fn)
     {
@@ -41,5 +44,21 @@ class merge_sequence : public base_sequence<typename helpers::deduce_result<Fn>:
         }
         return nullptr;
     }
+
+    std::size_t size() const
+    {
+        if constexpr (random_access)
+            return std::min(seq1.size(), seq2.size());
+        else
+            return base_sequence<value_type, merge_sequence<Seq1, Seq2, Fn>>::size();
+    }
+
+    const value_type &element(std::size_t i)
+        requires random_access
+    {
+        current = fn(seq1.element(i), seq2.element(i));
+        return current;
+    }
+
 };
 } // namespace cutty::sequences
@@ -0,0 +1,93 @@
+// Implements the terminal operations of a sequence in parallel on a thread pool.
+// The source is split into slices, the pipeline runs on each slice, and the results are combined.
+
+namespace cutty::sequences
+{
+template <typename Seq> class parallel_sequence
+{
+    static_assert(helpers::splittable_sequence<Seq>,
+                  "parallel() needs a splittable source, such as an array, a random access range or seq(a,b), "
+                  "with only where() and select() applied");
+
+    Seq seq;
+    thread_pool &pool;
+
+  public:
+    typedef typename Seq::value_type value_type;
+    typedef std::size_t size_type;
+
+    // Slices smaller than this are not split further
+    static constexpr size_type min_slice = 4096;
+
+    parallel_sequence(const Seq &seq, thread_pool &pool) : seq(seq), pool(pool)
+    {
+    }
+
+    // Aggregates each slice starting from 'init', then combines the results of the slices.
+    // 'init' must be an identity value for 'combine', such as 0 for addition.
+    template <typename U, typename Aggregate, typename Combine>
+    U aggregate(U init, Aggregate agg, Combine combine) const
+    {
+        auto results = for_each_slice([&](const auto &slice) { return slice.aggregate(init, agg); });
+        U result = init;
+        for (auto &r : results)
+            result = combine(result, *r);
+        return result;
+    }
+
+    template <typename Aggregate> value_type aggregate(Aggregate agg) const
+    {
+        return aggregate(value_type{}, agg, agg);
+    }
+
+    value_type sum() const
+    {
+        auto results = for_each_slice([](const auto &slice) { return slice.sum(); });
+        value_type result = {};
+        for (auto &r : results)
+            result = result + *r;
+        return result;
+    }
+
+    template <typename Predicate> size_type count(Predicate p) const
+    {
+        auto results = for_each_slice([&](const auto &slice) { return slice.count(p); });
+        size_type result = 0;
+        for (auto &r : results)
+            result += *r;
+        return result;
+    }
+
+    size_type size() const
+    {
+        auto results = for_each_slice([](const auto &slice) { return slice.size(); });
+        size_type result = 0;
+        for (auto &r : results)
+            result += *r;
+        return result;
+    }
+
+    // Slices that start after a match has been found are skipped
+    template <typename Predicate> bool any(Predicate p) const
+    {
+        std::atomic<bool> found = false;
+        for_each_slice([&](const auto &slice) {
+            if (!found.load(std::memory_order_relaxed) && slice.any(p))
+                found = true;
+            return true;
+        });
+        return found;
+    }
+
+  private:
+    template <typename Fn> auto for_each_slice(Fn fn) const
+    {
+        size_type n = seq.split_size();
+        size_type slices = std::clamp<size_type>(n / min_slice, 1, 4 * (pool.size() + 1));
+
+        std::vector<std::optional<decltype(fn(seq.slice(0, 0)))>> results(slices);
+        pool.run(slices, [&](std::size_t i) { results[i] = fn(seq.slice(n * i / slices, n * (i + 1) / slices)); });
+        return results;
+    }
+};
+} // namespace cutty::sequences
@@ -37,9 +37,38 @@ template <typename T> class pointer_sequence : public sequences::base_sequence<T
         return ++current == b ? nullptr : current;
     }
 
+    template <typename Fn> bool iterate(Fn fn) const
+    {
+        for (auto p = a; p != b; ++p)
+            if (!fn(*p))
+                return false;
+        return true;
+    }
+
     std::size_t size() const
     {
         return b - a;
     }
+
+    const T &element(std::size_t i)
+    {
+        return a[i];
+    }
+
+    pointer_sequence slice(std::size_t begin, std::size_t end) const
+    {
+        return {a + begin, a + end};
+    }
+
+    std::size_t split_size() const
+    {
+        return size();
+    }
+
+    // The elements are contiguous
+    const T *data() const
+    {
+        return a;
+    }
 };
 } // namespace cutty
\ No newline at end of file
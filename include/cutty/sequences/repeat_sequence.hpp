@@ -25,5 +25,32 @@ template <typename Seq> class repeat_sequence : public base_sequence<typename Se
             return result;
         return ++index < repeat ? seq.first() : nullptr;
     }
+
+    std::size_t size() const
+    {
+        if constexpr (helpers::random_access_sequence<Seq>)
+            return repeat > 0 ? repeat * seq.size() : 0;
+        else
+            return base_sequence<typename Seq::value_type, repeat_sequence<Seq>>::size();
+    }
+
+    helpers::size_hint size_hint() const
+    {
+        return seq.size_hint() * (repeat > 0 ? repeat : 0);
+    }
+
+    const typename Seq::value_type &element(std::size_t i)
+        requires helpers::random_access_sequence<Seq>
+    {
+        return seq.element(i % seq.size());
+    }
+
+    template <typename Fn> bool iterate(Fn fn) const
+    {
+        for (int i = 0; i < repeat; ++i)
+            if (!seq.iterate(fn))
+                return false;
+        return true;
+    }
 };
 } // namespace cutty::sequences
@@ -47,9 +47,41 @@ class select_sequence : public base_sequence<typename helpers::deduce_result<Fn>
         }
     }
 
-    std::size_t size()
+    auto slice(std::size_t begin, std::size_t end) const
+        requires helpers::splittable_sequence<Seq>
+    {
+        auto s = seq.slice(begin, end);
+        return select_sequence<T, decltype(s), Fn>(s, fn);
+    }
+
+    std::size_t split_size() const
+        requires helpers::splittable_sequence<Seq>
+    {
+        return seq.split_size();
+    }
+
+    template <typename Fn2> bool iterate(Fn2 fn2) const
+    {
+        // As with self(), const methods call the function non-const, like first() and next()
+        auto &f = const_cast<Fn &>(fn);
+        return seq.iterate([&](const T &i) { return fn2(f(i)); });
+    }
+
+    helpers::size_hint size_hint() const
+    {
+        return seq.size_hint();
+    }
+
+    std::size_t size() const
     {
         return seq.size();
     }
+
+    const value_type &element(std::size_t i)
+        requires helpers::random_access_sequence<Seq>
+    {
+        current = fn(seq.element(i));
+        return current;
+    }
 };
 } // namespace cutty::sequences
@@ -9,5 +9,53 @@ template <typename T> class sequence : public sequences::base_sequence<T, sequen
     virtual const value_type *first() = 0;
     virtual const value_type *next() = 0;
     virtual std::size_t size() = 0;
+
+    // The largest number of elements fetched per virtual call by iterate()
+    static constexpr std::size_t batch_size = 256;
+
+    // Batch iteration: copies the first elements into the buffer, and returns how many were copied.
+    // A batch smaller than the buffer is the last batch. The buffer must not be empty.
+    // The default implementation uses first() and next(), but derived classes can override
+    // these to fill a whole batch in one virtual call.
+    virtual std::size_t first_batch(std::span<T> buffer)
+    {
+        return sequences::helpers::fill_batch(first(), buffer, [this] { return next(); });
+    }
+
+    // Copies the next elements into the buffer, after a full batch
+    virtual std::size_t next_batch(std::span<T> buffer)
+    {
+        return sequences::helpers::fill_batch(next(), buffer, [this] { return next(); });
+    }
+
+    // Internal iteration in batches, so that the virtual call overhead is
+    // paid once per batch instead of twice per element.
+    // Batches start with a single element and double in size, so if fn stops early,
+    // no more elements are read ahead than fn has already seen.
+    template <typename Fn> bool iterate(Fn fn) const
+    {
+        if constexpr (batchable)
+        {
+            std::array<T, batch_size> buffer;
+            auto &s = this->self();
+            std::size_t size = 1;
+            for (auto n = s.first_batch({buffer.data(), size});; n = s.next_batch({buffer.data(), size}))
+            {
+                for (std::size_t i = 0; i < n; ++i)
+                    if (!fn(buffer[i]))
+                        return false;
+                if (n < size)
+                    return true;
+                size = std::min(2 * size, batch_size);
+            }
+        }
+        else
+            return sequences::base_sequence<T, sequence<T>, sequences::sequence_ref<T>>::iterate(fn);
+    }
+
+  private:
+    // Only batch elements that are cheap to copy into a buffer on the stack
+    static constexpr bool batchable =
+        std::is_default_constructible_v<T> && std::is_trivially_copyable_v<T> && sizeof(T) <= 64;
 };
-} // namespace cutty
\ No newline at end of file
+} // namespace cutty
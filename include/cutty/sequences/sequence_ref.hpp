@@ -22,5 +22,10 @@ template <typename T> class sequence_ref : public base_sequence<T, sequence_ref<
     {
         return seq.size();
     }
+
+    template <typename Fn> bool iterate(Fn fn) const
+    {
+        return seq.iterate(fn);
+    }
 };
 } // namespace cutty::sequences
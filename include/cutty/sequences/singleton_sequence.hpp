@@ -18,9 +18,19 @@ template <typename T> class singleton_sequence : public base_sequence<T, singlet
     {
         return nullptr;
     }
+    template <typename Fn> bool iterate(Fn fn) const
+    {
+        return fn(value);
+    }
+
     std::size_t size() const
     {
         return 1;
     }
+
+    helpers::size_hint size_hint() const
+    {
+        return {helpers::size_hint::exact, 1};
+    }
 };
 } // namespace cutty::sequences
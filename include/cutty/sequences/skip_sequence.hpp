@@ -6,23 +6,84 @@ template <typename T, typename Seq> class skip_sequence : public base_sequence<T
 {
     Seq seq;
     int to_skip;
+    std::size_t index, limit; // Used for random access
+
+    static constexpr bool random_access = helpers::random_access_sequence<Seq>;
+
+    std::size_t start() const
+    {
+        return to_skip > 0 ? to_skip : 0;
+    }
 
   public:
     skip_sequence(const Seq &u, int count) : seq(u), to_skip(count)
     {
     }
 
+    // Random access sequences jump straight to the first element
     const T *first()
     {
-        auto result = seq.first();
-        for (int i = 0; result && i < to_skip; i++)
-            result = seq.next();
-        return result;
+        if constexpr (random_access)
+        {
+            index = start();
+            limit = seq.size();
+            return index < limit ? &seq.element(index) : nullptr;
+        }
+        else
+        {
+            auto result = seq.first();
+            for (int i = 0; result && i < to_skip; i++)
+                result = seq.next();
+            return result;
+        }
     }
 
     const T *next()
     {
-        return seq.next();
+        if constexpr (random_access)
+            return ++index < limit ? &seq.element(index) : nullptr;
+        else
+            return seq.next();
+    }
+
+    template <typename Fn> bool iterate(Fn fn) const
+    {
+        if constexpr (random_access)
+        {
+            // As with self(), const methods actually modify internal state
+            auto &s = const_cast<Seq &>(seq);
+            for (std::size_t i = start(), n = s.size(); i < n; ++i)
+                if (!fn(s.element(i)))
+                    return false;
+            return true;
+        }
+        else
+        {
+            int skipped = 0;
+            return seq.iterate([&](const T &i) { return skipped < to_skip ? (++skipped, true) : fn(i); });
+        }
+    }
+
+    std::size_t size() const
+    {
+        if constexpr (random_access)
+        {
+            auto n = seq.size();
+            return n > start() ? n - start() : 0;
+        }
+        else
+            return base_sequence<T, skip_sequence<T, Seq>>::size();
+    }
+
+    helpers::size_hint size_hint() const
+    {
+        return seq.size_hint().without(start());
+    }
+
+    const T &element(std::size_t i)
+        requires random_access
+    {
+        return seq.element(start() + i);
     }
 };
 } // namespace cutty::sequences
@@ -27,5 +27,22 @@ class skip_until_sequence : public base_sequence<typename Seq::value_type, skip_
     {
         return seq.next();
     }
+
+    helpers::size_hint size_hint() const
+    {
+        return seq.size_hint().filtered();
+    }
+
+    template <typename Fn> bool iterate(Fn fn) const
+    {
+        // As with self(), const methods call the predicate non-const, like first() and next()
+        auto &p = const_cast<Predicate &>(predicate);
+        bool found = false;
+        return seq.iterate([&](const value_type &i) {
+            if (!found && !(found = p(i)))
+                return true;
+            return fn(i);
+        });
+    }
 };
 } // namespace cutty::sequences
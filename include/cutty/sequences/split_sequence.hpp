@@ -5,9 +5,9 @@ namespace cutty::sequences
 template <typename Seq>
 class split_sequence : public base_sequence<std::basic_string<typename Seq::value_type>, split_sequence<Seq>>
 {
-    Seq seq;
-    const typename Seq::value_type *splitChars;
     typedef typename Seq::value_type char_type;
+    Seq seq;
+    helpers::char_set<char_type> splitChars;
 
   public:
     typedef std::basic_string<typename Seq::value_type> value_type;
@@ -21,10 +21,7 @@ class split_sequence : public base_sequence<std::basic_string<typename Seq::valu
 
     bool isSplit(char_type ch) const
     {
-        for (auto i = splitChars; *i; i++)
-            if (ch == *i)
-                return true;
-        return false;
+        return splitChars.contains(ch);
     }
 
     const value_type *first()
@@ -0,0 +1,54 @@
+// Implements a sequence that splits contiguous characters into tokens without copying them.
+// Each token is a std::basic_string_view into the original characters.
+
+namespace cutty::sequences
+{
+template <typename Char>
+class split_view_sequence : public base_sequence<std::basic_string_view<Char>, split_view_sequence<Char>>
+{
+    const Char *a, *b, *current;
+    helpers::char_set<Char> delimiters;
+
+  public:
+    typedef std::basic_string_view<Char> value_type;
+
+    split_view_sequence(const Char *a, const Char *b, const Char *chs) : a(a), b(b), delimiters(chs)
+    {
+    }
+
+    value_type token;
+
+    // Finds the token starting at or after p, and moves p to the end of the token
+    bool find(const Char *&p, value_type &result) const
+    {
+        while (p != b && delimiters.contains(*p))
+            ++p;
+        if (p == b)
+            return false;
+        auto start = p;
+        p = delimiters.find(p, b);
+        result = {start, std::size_t(p - start)};
+        return true;
+    }
+
+    const value_type *first()
+    {
+        current = a;
+        return next();
+    }
+
+    const value_type *next()
+    {
+        return find(current, token) ? &token : nullptr;
+    }
+
+    template <typename Fn> bool iterate(Fn fn) const
+    {
+        value_type t;
+        for (auto p = a; find(p, t);)
+            if (!fn(t))
+                return false;
+        return true;
+    }
+};
+} // namespace cutty::sequences
@@ -30,9 +30,43 @@ class stored_sequence : public base_sequence<std::ranges::range_value_t<Containe
         return current == container.end() ? nullptr : &*current;
     }
 
-    std::size_t size()
+    template <typename Fn> bool iterate(Fn fn) const
+    {
+        for (auto &i : container)
+            if (!fn(i))
+                return false;
+        return true;
+    }
+
+    std::size_t size() const
     {
         return std::ranges::distance(container);
     }
+
+    const value_type &element(std::size_t i)
+        requires std::ranges::random_access_range<Container>
+    {
+        return std::ranges::begin(container)[i];
+    }
+
+    // Slices refer to the stored container, so must not outlive this sequence
+    auto slice(std::size_t begin, std::size_t end) const
+        requires std::ranges::random_access_range<const Container>
+    {
+        auto b = std::ranges::begin(container);
+        return iterator_sequence{b + begin, b + end};
+    }
+
+    std::size_t split_size() const
+    {
+        return size();
+    }
+
+    // Contiguous containers give contiguous sequences
+    const value_type *data() const
+        requires std::ranges::contiguous_range<Container>
+    {
+        return std::ranges::data(container);
+    }
 };
 } // namespace cutty::sequences
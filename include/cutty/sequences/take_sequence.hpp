@@ -22,5 +22,37 @@ template <typename T, typename Seq> class take_sequence : public base_sequence<T
     {
         return (++index) < to_take ? seq.next() : nullptr;
     }
+
+    template <typename Fn> bool iterate(Fn fn) const
+    {
+        int remaining = to_take;
+        bool stopped = false;
+        if (remaining > 0)
+            seq.iterate([&](const T &i) {
+                if (!fn(i))
+                    return !(stopped = true);
+                return --remaining > 0;
+            });
+        return !stopped;
+    }
+
+    std::size_t size() const
+    {
+        if constexpr (helpers::random_access_sequence<Seq>)
+            return to_take > 0 ? std::min<std::size_t>(to_take, seq.size()) : 0;
+        else
+            return base_sequence<T, take_sequence<T, Seq>>::size();
+    }
+
+    helpers::size_hint size_hint() const
+    {
+        return seq.size_hint().at_most(to_take > 0 ? to_take : 0);
+    }
+
+    const T &element(std::size_t i)
+        requires helpers::random_access_sequence<Seq>
+    {
+        return seq.element(i);
+    }
 };
 } // namespace cutty::sequences
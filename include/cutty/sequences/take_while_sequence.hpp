@@ -28,5 +28,27 @@ class take_while_sequence : public base_sequence<typename Seq::value_type, take_
         auto result = seq.next();
         return result && !predicate(*result) ? nullptr : result;
     }
+
+    helpers::size_hint size_hint() const
+    {
+        return seq.size_hint().filtered();
+    }
+
+    // Like first(), skips leading elements that do not match the predicate
+    template <typename Fn> bool iterate(Fn fn) const
+    {
+        // As with self(), const methods call the predicate non-const, like first() and next()
+        auto &p = const_cast<Predicate &>(predicate);
+        bool started = false, stopped = false;
+        seq.iterate([&](const value_type &i) {
+            if (!p(i))
+                return !started;
+            started = true;
+            if (!fn(i))
+                return !(stopped = true);
+            return true;
+        });
+        return !stopped;
+    }
 };
 } // namespace cutty::sequences
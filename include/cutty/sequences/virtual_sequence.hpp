@@ -22,5 +22,16 @@ template <typename T, typename Seq> class virtual_sequence : public sequence<T>
     {
         return std::ranges::distance(seq);
     }
+
+    // Runs the underlying pipeline over a whole batch, without virtual calls
+    std::size_t first_batch(std::span<T> buffer) override
+    {
+        return helpers::fill_batch(seq.first(), buffer, [this] { return seq.next(); });
+    }
+
+    std::size_t next_batch(std::span<T> buffer) override
+    {
+        return helpers::fill_batch(seq.next(), buffer, [this] { return seq.next(); });
+    }
 };
 } // namespace cutty::sequences
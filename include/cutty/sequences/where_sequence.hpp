@@ -29,5 +29,30 @@ class where_sequence : public base_sequence<T, where_sequence<T, Seq, Predicate>
         while (result && !pred(*result));
         return result;
     }
+
+    auto slice(std::size_t begin, std::size_t end) const
+        requires helpers::splittable_sequence<Seq>
+    {
+        auto s = seq.slice(begin, end);
+        return where_sequence<T, decltype(s), Predicate>(s, pred);
+    }
+
+    std::size_t split_size() const
+        requires helpers::splittable_sequence<Seq>
+    {
+        return seq.split_size();
+    }
+
+    helpers::size_hint size_hint() const
+    {
+        return seq.size_hint().filtered();
+    }
+
+    template <typename Fn> bool iterate(Fn fn) const
+    {
+        // As with self(), const methods call the predicate non-const, like first() and next()
+        auto &p = const_cast<Predicate &>(pred);
+        return seq.iterate([&](const T &i) { return !p(i) || fn(i); });
+    }
 };
 } // namespace cutty::sequences
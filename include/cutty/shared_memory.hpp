@@ -2,6 +2,7 @@
 
 #include <cstdint>
 #include <system_error>
+#include <vector>
 
 namespace cutty
 {
@@ -17,12 +18,45 @@ class shared_memory
 
     enum flags
     {
-        create = 1,    /// File may be created if it does not exist
-        readonly = 2,  /// File and contents are not writable
-        Private = 4,   /// Changes are discarded
-        exclusive = 8, /// Ensure not open by anyone else
-        pinned = 16,   /// Fail if the specified address cannot be used
-        trunc = 32     /// Delete any existing file
+        create = 1,         /// File may be created if it does not exist
+        readonly = 2,       /// File and contents are not writable
+        Private = 4,        /// Changes are discarded
+        exclusive = 8,      /// Ensure not open by anyone else
+        pinned = 16,        /// Fail if the specified address cannot be used
+        trunc = 32,         /// Delete any existing file
+        huge_pages = 64,    /// Back the mapping with transparent huge pages where supported
+        sequential = 128,   /// Pages are accessed sequentially, so read ahead aggressively
+        random = 256,       /// Pages are accessed randomly, so do not read ahead
+        prefault = 512,     /// Read the entire file into memory when it is mapped
+        sealed = 1024,      /// Anonymous memory cannot be resized once created
+        preallocate = 2048, /// Allocate disk blocks when the file grows, instead of creating a sparse file
+        ring = 4096         /// Map the file twice, back to back, so data wrapping around the end is contiguous
+    };
+
+    /** Hints passed to advise() */
+    enum class hint
+    {
+        normal,     /// The default paging behaviour
+        sequential, /// Expect sequential access, so read ahead aggressively
+        random,     /// Expect random access, so do not read ahead
+        willneed,   /// The range will be accessed soon, so start reading it in
+        dontneed,   /// The range will not be accessed soon, so its pages can be released
+        huge_pages, /// Back the range with transparent huge pages
+        cold        /// The range will not be accessed soon, so reclaim it first under memory pressure
+    };
+
+    /** Which pages of a range are resident in memory, as returned by residency() */
+    struct page_residency
+    {
+        size_type page_size = 0;
+        size_type resident_pages = 0;
+        std::vector<bool> pages; /// One entry per page, true if resident
+
+        /** The fraction of pages that are resident, from 0 to 1 */
+        double fraction() const
+        {
+            return pages.empty() ? 1.0 : double(resident_pages) / pages.size();
+        }
     };
 
     /** Creates an empty shared_memory */
@@ -42,6 +76,21 @@ class shared_memory
     shared_memory(const char *filename, std::error_code &ec, int flags = create, size_type min_size = 0,
                   void *hint = 0x0);
 
+    /**
+        Creates anonymous shared memory, which is not backed by a file on disk.
+        The memory can be shared with other processes by passing fd() to them, for example using send_fd().
+        On Linux this uses memfd_create, and the sealed flag prevents the size from being changed.
+        Not supported on Windows.
+     */
+    shared_memory(std::error_code &ec, size_type size, int flags = 0, void *hint = 0x0);
+
+    /**
+        Maps an open file descriptor, for example one received using receive_fd().
+        Takes ownership of @p fd, which is closed if the operation fails.
+        Not supported on Windows.
+     */
+    shared_memory(int fd, std::error_code &ec, int flags = 0, void *hint = 0x0);
+
     /**
         Moves shared memory object, leaving @p src in an invalid state.
      */
@@ -50,7 +99,11 @@ class shared_memory
 
     ~shared_memory();
 
-    /** Returns the current data, or nullptr if empty */
+    /**
+        Returns the current data, or nullptr if empty.
+        With the ring flag, size() bytes from data() are mapped again immediately after the first
+        size() bytes, so any range of up to size() bytes starting within the file is contiguous.
+     */
     void *data()
     {
         return m_data;
@@ -74,6 +127,37 @@ class shared_memory
         return m_size;
     }
 
+    /** Returns the size of a page of memory */
+    static size_type page_size();
+
+    /** Returns the file descriptor, or -1 if empty or not available on this platform */
+    int fd() const
+    {
+        return m_fd;
+    }
+
+    /**
+        Prevents the size of anonymous memory from being changed, by this or any other process.
+        Only supported for anonymous memory on Linux.
+     */
+    void seal(std::error_code &ec);
+
+    /** Returns the granularity that disk blocks are preallocated in */
+    size_type growth_chunk() const
+    {
+        return m_growth_chunk;
+    }
+
+    /**
+        Sets the granularity that disk blocks are preallocated in, when the preallocate flag is set.
+        Growing the file reserves blocks up to the next multiple of @p chunk, without changing the file size,
+        so that repeated small extensions do not fragment the file. 0 allocates exactly the requested size.
+     */
+    void growth_chunk(size_type chunk)
+    {
+        m_growth_chunk = chunk;
+    }
+
     /**
         Resizes the current data to the current file size (if changed),
         or the new minimum size.
@@ -97,6 +181,41 @@ class shared_memory
      */
     void reopen_at(std::error_code &ec, void *address);
 
+    /**
+        Tells the operating system how a range of the mapping will be accessed.
+        A @p length of 0 means the rest of the mapping. The range is extended to whole pages.
+        Hints that are not supported on the current platform are ignored.
+     */
+    void advise(std::error_code &ec, size_type offset, size_type length, hint h);
+
+    /**
+        Returns which pages in a range of the mapping are resident in memory, using mincore.
+        A @p length of 0 means the rest of the mapping. The range is extended to whole pages.
+        Not supported on Windows.
+     */
+    page_residency residency(std::error_code &ec, size_type offset = 0, size_type length = 0) const;
+
+    /**
+        Starts reading a range of the mapping into memory, so that later accesses do not block.
+        A @p length of 0 means the rest of the mapping.
+     */
+    void prefetch(std::error_code &ec, size_type offset = 0, size_type length = 0);
+
+    /**
+        Tells the operating system that a range of the mapping will not be used soon.
+        By default the pages are only marked as cold, so they are reclaimed first under memory pressure.
+        If @p drop is true, the pages are removed from the mapping immediately.
+        The contents of the file are not affected. A @p length of 0 means the rest of the mapping.
+     */
+    void evict(std::error_code &ec, size_type offset = 0, size_type length = 0, bool drop = false);
+
+    /**
+        Writes modified pages in a range of the mapping to the file.
+        A @p length of 0 means the rest of the mapping. The range is extended to whole pages.
+        If @p sync is true, waits until the data is written, otherwise only starts writeback.
+     */
+    void flush(std::error_code &ec, size_type offset = 0, size_type length = 0, bool sync = true);
+
     /**
         Closes the file if open, otherwise does nothing.
     */
@@ -113,10 +232,27 @@ class shared_memory
     int m_fd;
     void *m_file_handle, *m_map_handle;
     int m_map_flags;
+    int m_flags;
+    size_type m_growth_chunk;
 
+    void map(std::error_code &ec, int fd, int flags, size_type initial_size, void *hint);
+    void apply_flags();
+    void remap_ring(std::error_code &ec, size_type new_size, void *address);
     void remap(std::error_code &ec, size_type new_size);
+    bool valid_size(std::error_code &ec, size_type new_size) const;
     bool truncate(std::error_code &ec, size_type new_size);
     size_type get_size() const;
     void unmap();
 };
+
+/**
+    Sends a file descriptor over a Unix domain socket, using SCM_RIGHTS.
+    The receiving process gets its own descriptor for the same file.
+ */
+void send_fd(std::error_code &ec, int socket, int fd);
+
+/**
+    Receives a file descriptor sent by send_fd(), or returns -1 on failure.
+ */
+int receive_fd(std::error_code &ec, int socket);
 } // namespace cutty
\ No newline at end of file
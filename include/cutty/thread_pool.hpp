@@ -0,0 +1,82 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace cutty
+{
+/**
+    A pool of worker threads that share work by stealing.
+
+    Each worker has its own queue of tasks. A worker takes tasks from the back of its own queue,
+    and when that is empty, steals from the front of other workers' queues, so that the load
+    is balanced without a single shared queue.
+
+    The thread calling run() also runs tasks while it waits, so run() can be called from
+    inside a task without deadlocking.
+ */
+class thread_pool
+{
+  public:
+    /** Starts @p threads worker threads */
+    explicit thread_pool(unsigned threads = std::thread::hardware_concurrency());
+
+    thread_pool(const thread_pool &) = delete;
+    thread_pool &operator=(const thread_pool &) = delete;
+
+    /** Waits for queued tasks to finish, and stops the worker threads */
+    ~thread_pool();
+
+    /** The number of worker threads */
+    unsigned size() const
+    {
+        return unsigned(m_threads.size());
+    }
+
+    /**
+        Calls fn(i) for each i from 0 to n-1 on the pool, and waits for them to finish.
+        If any call throws, the first exception is rethrown once all of the calls have finished.
+     */
+    void run(std::size_t n, const std::function<void(std::size_t)> &fn);
+
+    /** A pool with one thread per hardware thread, created on first use */
+    static thread_pool &default_pool();
+
+  private:
+    struct job;
+
+    struct task
+    {
+        job *owner;
+        std::size_t index;
+    };
+
+    struct queue
+    {
+        std::mutex mutex;
+        std::deque<task> tasks;
+    };
+
+    std::vector<std::unique_ptr<queue>> m_queues;
+    std::vector<std::thread> m_threads;
+    std::atomic<std::size_t> m_next_queue;
+
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::size_t m_pending; // Tasks in queues, protected by m_mutex
+    bool m_stop;
+
+    bool pop(std::size_t q, task &t);
+    bool steal(std::size_t q, task &t);
+    void execute(const task &t);
+    void run_worker(std::size_t q);
+};
+} // namespace cutty
@@ -0,0 +1,171 @@
+#pragma once
+
+#include "shared_memory.hpp"
+
+#include <cstddef>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+namespace cutty
+{
+/**
+    A memory-mapped view of a file that maps fixed-size windows of the file on demand.
+
+    shared_memory maps the entire file, which is not possible or desirable for very large files.
+    windowed_memory only maps the windows that are in use, and keeps a least-recently-used cache
+    of at most max_windows mapped windows, so the address space and resident memory are bounded.
+
+    A window is accessed through a view, which pins the window so that it is not unmapped
+    until the view is destroyed. If every cached window is pinned, further windows are still
+    mapped, and the cache shrinks back to max_windows as views are released.
+
+    Mapping and unmapping are mutexed, so views can be obtained from several threads.
+ */
+class windowed_memory
+{
+  public:
+    using size_type = shared_memory::size_type;
+
+    static constexpr size_type default_window_size = size_type(1) << 26;
+    static constexpr std::size_t default_max_windows = 16;
+
+  private:
+    struct window
+    {
+        size_type index;
+        void *data;
+        size_type size;
+        unsigned pins;
+    };
+
+    // The index of a window that is no longer in the cache
+    static constexpr size_type retired = ~size_type(0);
+
+  public:
+    /**
+        A pinned range of the file, which remains mapped while the view exists.
+     */
+    class view
+    {
+      public:
+        /** Creates an empty view */
+        view();
+
+        view(view &&src);
+        view &operator=(view &&src);
+
+        view(const view &) = delete;
+        view &operator=(const view &) = delete;
+
+        /** Unpins the window */
+        ~view();
+
+        /** Returns the data at the requested offset, or nullptr if empty */
+        void *data() const
+        {
+            return m_data;
+        }
+
+        /** Returns the number of bytes available from data() to the end of the window */
+        size_type size() const
+        {
+            return m_size;
+        }
+
+        /** Returns the offset of data() in the file */
+        size_type offset() const
+        {
+            return m_offset;
+        }
+
+        /** Returns if this view is not empty */
+        explicit operator bool() const
+        {
+            return m_data;
+        }
+
+        /** Unpins the window and empties the view */
+        void release();
+
+      private:
+        friend windowed_memory;
+        view(windowed_memory *owner, window *w, size_type offset);
+
+        windowed_memory *m_owner;
+        window *m_window;
+        void *m_data;
+        size_type m_size, m_offset;
+    };
+
+    /** Creates an empty windowed_memory */
+    windowed_memory();
+
+    /**
+        Opens or creates a file. @p flags are shared_memory::flags, and the access hints
+        are applied to each window as it is mapped.
+        The window size is rounded up to a multiple of the platform's mapping granularity.
+        If the operation failed, the windowed_memory is empty and ec contains the error code.
+     */
+    windowed_memory(const char *filename, std::error_code &ec, int flags = shared_memory::create,
+                    size_type min_size = 0, size_type window_size = default_window_size,
+                    std::size_t max_windows = default_max_windows);
+
+    windowed_memory(const windowed_memory &) = delete;
+    windowed_memory &operator=(const windowed_memory &) = delete;
+
+    /** Closes the file. All views must have been released. */
+    ~windowed_memory();
+
+    /** Returns if the file is open */
+    explicit operator bool() const;
+
+    /** Returns the size of the file */
+    size_type size() const;
+
+    size_type window_size() const
+    {
+        return m_window_size;
+    }
+
+    std::size_t max_windows() const
+    {
+        return m_max_windows;
+    }
+
+    /** Returns the number of windows currently mapped */
+    std::size_t mapped_windows() const;
+
+    /**
+        Returns a view of the window containing @p offset, mapping it if necessary.
+        The view extends from @p offset to the end of the window or the end of the file.
+        If the window could not be mapped, the view is empty and ec contains the error code.
+     */
+    view map(std::error_code &ec, size_type offset);
+
+    /**
+        Resizes (grows or shrinks) the file. Windows that are not pinned are unmapped.
+        Views of data beyond the new size must not be used.
+     */
+    void resize(std::error_code &ec, size_type new_size);
+
+    /**
+        Closes the file if open, otherwise does nothing. All views must have been released.
+     */
+    void close();
+
+  private:
+    mutable std::mutex m_mutex;
+    std::list<window> m_windows; // Most recently used first
+    std::unordered_map<size_type, std::list<window>::iterator> m_index;
+    size_type m_size, m_window_size;
+    std::size_t m_max_windows;
+    int m_flags;
+    int m_fd;
+    void *m_file_handle, *m_map_handle;
+
+    void unpin(window *w);
+    void unmap(window &w);
+    void evict(std::size_t max_windows);
+};
+} // namespace cutty
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "shared_memory.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <thread>
+
+namespace cutty
+{
+/**
+    Writes dirty ranges of a shared_memory back to its file from a background thread.
+
+    Without writeback, modified pages are either written whenever the kernel chooses, or all at once
+    when the shared_memory is closed, which can stall for seconds. Instead, the writer calls mark_dirty()
+    after modifying a range, and the background thread flushes the dirty ranges once the amount of dirty
+    data or the age of the oldest change crosses a threshold. This spreads the I/O out over time.
+
+    The shared_memory must not be resized or moved while a writeback is attached to it.
+ */
+class writeback
+{
+  public:
+    using size_type = shared_memory::size_type;
+    using duration = std::chrono::steady_clock::duration;
+
+    /** When and how dirty ranges are written */
+    struct policy
+    {
+        /// Flush when this much data is dirty
+        size_type dirty_bytes = size_type(64) << 20;
+
+        /// Flush when the oldest change is this old
+        duration max_age = std::chrono::seconds(5);
+
+        /// How often to check the age of the oldest change
+        duration interval = std::chrono::milliseconds(100);
+
+        /// Wait for each flush to complete, rather than just starting writeback
+        bool sync = false;
+    };
+
+    /** Statistics about flushes */
+    struct statistics
+    {
+        std::size_t flushes = 0;  /// The number of ranges flushed
+        size_type bytes = 0;      /// The number of bytes flushed
+        std::size_t errors = 0;   /// The number of flushes that failed
+        duration total_latency{}; /// The total time spent flushing
+        duration max_latency{};   /// The longest time spent flushing a single range
+
+        duration mean_latency() const
+        {
+            return flushes ? total_latency / duration::rep(flushes) : duration{};
+        }
+    };
+
+    /** Starts a background thread to write back @p memory with the default policy */
+    writeback(shared_memory &memory);
+
+    /** Starts a background thread to write back @p memory */
+    writeback(shared_memory &memory, const policy &p);
+
+    writeback(const writeback &) = delete;
+    writeback &operator=(const writeback &) = delete;
+
+    /** Stops the background thread, and flushes any remaining dirty ranges */
+    ~writeback();
+
+    /** Records that a range of the memory has been modified */
+    void mark_dirty(size_type offset, size_type length);
+
+    /**
+        Flushes all dirty ranges now, from the calling thread.
+        A synchronous flush also waits for the background thread's flushes in progress,
+        and re-issues any ranges whose writeback was only started.
+     */
+    void flush(std::error_code &ec, bool sync = true);
+
+    /** The number of bytes that have been marked dirty but not yet flushed */
+    size_type dirty_bytes() const;
+
+    statistics stats() const;
+
+  private:
+    shared_memory &m_memory;
+    const policy m_policy;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::map<size_type, size_type> m_dirty; // Disjoint dirty ranges, from start to end
+    size_type m_dirty_bytes = 0;
+    std::map<size_type, size_type> m_unsynced; // Ranges flushed without waiting for completion
+    std::condition_variable m_flushed;
+    std::size_t m_in_flight = 0; // The number of flush_dirty() calls doing I/O
+    std::chrono::steady_clock::time_point m_oldest;
+    statistics m_stats;
+    bool m_stop = false;
+    std::thread m_thread;
+
+    void run();
+    void flush_dirty(std::unique_lock<std::mutex> &lock, bool sync, std::error_code &ec);
+};
+} // namespace cutty
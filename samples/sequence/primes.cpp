@@ -8,7 +8,11 @@ int main()
     auto primes =
         cy::seq(2, 1000000).where([](int n) { return !cy::seq(2, n - 1).any([=](int m) { return n % m == 0; }); });
 
-    for (int p : primes.take(100))
+    // cache() stores the primes as they are found, so they are only computed once
+    auto first = primes.take(100).cache();
+    std::cout << "The first " << first.size() << " primes sum to " << first.sum() << std::endl;
+
+    for (int p : first)
         std::cout << p << std::endl;
 
     return 0;
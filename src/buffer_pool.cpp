@@ -0,0 +1,532 @@
+#include <cutty/buffer_pool.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+
+#if !WIN32
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace cy = cutty;
+
+namespace
+{
+// The alignment of frames, offsets and lengths required by O_DIRECT
+constexpr cy::buffer_pool::size_type direct_alignment = 4096;
+} // namespace
+
+cy::buffer_pool::pin::pin() : m_pool(nullptr), m_frame(0), m_page(0), m_data(nullptr), m_size(0)
+{
+}
+
+cy::buffer_pool::pin::pin(buffer_pool *pool, std::size_t frame, size_type page, void *data, size_type size)
+    : m_pool(pool), m_frame(frame), m_page(page), m_data(data), m_size(size)
+{
+}
+
+cy::buffer_pool::pin::pin(pin &&src)
+    : m_pool(src.m_pool), m_frame(src.m_frame), m_page(src.m_page), m_data(src.m_data), m_size(src.m_size)
+{
+    src.m_pool = nullptr;
+    src.m_data = nullptr;
+    src.m_size = 0;
+}
+
+cy::buffer_pool::pin &cy::buffer_pool::pin::operator=(pin &&src)
+{
+    if (this != &src)
+    {
+        release();
+        std::swap(m_pool, src.m_pool);
+        std::swap(m_frame, src.m_frame);
+        std::swap(m_page, src.m_page);
+        std::swap(m_data, src.m_data);
+        std::swap(m_size, src.m_size);
+    }
+    return *this;
+}
+
+cy::buffer_pool::pin::~pin()
+{
+    release();
+}
+
+void cy::buffer_pool::pin::mark_dirty()
+{
+    assert(m_pool);
+    std::lock_guard<std::mutex> lock(m_pool->m_mutex);
+    m_pool->m_frames[m_frame].dirty = true;
+}
+
+void cy::buffer_pool::pin::release()
+{
+    if (m_pool)
+    {
+        m_pool->unpin(m_frame);
+        m_pool = nullptr;
+        m_data = nullptr;
+        m_size = 0;
+    }
+}
+
+cy::buffer_pool::buffer_pool()
+    : m_fd(-1), m_direct(false), m_size(0), m_page_size(0), m_memory(nullptr), m_clock(0), m_stop(false)
+{
+}
+
+cy::buffer_pool::buffer_pool(const char *filename, std::error_code &ec, int flags, size_type min_size)
+    : buffer_pool(filename, ec, flags, min_size, options())
+{
+}
+
+cy::buffer_pool::buffer_pool(const char *filename, std::error_code &ec, int flags, size_type min_size,
+                             const options &opts)
+    : buffer_pool()
+{
+#if WIN32
+    ec = std::make_error_code(std::errc::function_not_supported);
+#else
+    int fd_flags = 0;
+    if (flags & shared_memory::create)
+        fd_flags |= O_CREAT;
+    if (flags & shared_memory::readonly)
+        fd_flags |= O_RDONLY;
+    else
+        fd_flags |= O_RDWR;
+    if (flags & shared_memory::exclusive)
+        fd_flags |= O_EXCL;
+    if (flags & shared_memory::trunc)
+        fd_flags |= O_TRUNC;
+#if defined(O_DIRECT)
+    if (opts.direct)
+        fd_flags |= O_DIRECT;
+#endif
+
+    int fd = open(filename, fd_flags, 0600);
+
+    if (fd < 0)
+    {
+        ec = {errno, std::generic_category()};
+        return;
+    }
+    m_fd = fd;
+    m_direct = opts.direct;
+
+#if defined(F_NOCACHE)
+    if (opts.direct)
+        fcntl(fd, F_NOCACHE, 1);
+#endif
+#if defined(POSIX_FADV_RANDOM)
+    // The pool does its own caching and prefetching
+    if (!opts.direct && !(flags & shared_memory::sequential))
+        posix_fadvise(fd, 0, 0, POSIX_FADV_RANDOM);
+#endif
+
+    struct stat st;
+    if (fstat(fd, &st))
+    {
+        ec = {errno, std::generic_category()};
+        close();
+        return;
+    }
+    m_size = st.st_size;
+
+    m_page_size = (opts.page_size + direct_alignment - 1) / direct_alignment * direct_alignment;
+    if (!m_page_size)
+        m_page_size = direct_alignment;
+
+    std::size_t frames = opts.frames ? opts.frames : 1;
+    m_memory = (std::byte *)std::aligned_alloc(direct_alignment, frames * m_page_size);
+    if (!m_memory)
+    {
+        ec = std::make_error_code(std::errc::not_enough_memory);
+        close();
+        return;
+    }
+    m_frames.resize(frames);
+
+    if (m_size < min_size)
+    {
+        resize(ec, min_size);
+        if (ec)
+        {
+            close();
+            return;
+        }
+    }
+
+    for (unsigned i = 0; i < opts.io_threads; ++i)
+        m_io_threads.emplace_back([this] { run_io(); });
+#endif
+}
+
+cy::buffer_pool::~buffer_pool()
+{
+    close();
+}
+
+cy::buffer_pool::size_type cy::buffer_pool::size() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_size;
+}
+
+cy::buffer_pool::size_type cy::buffer_pool::page_count() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_page_size ? (m_size + m_page_size - 1) / m_page_size : 0;
+}
+
+cy::buffer_pool::pin cy::buffer_pool::get(std::error_code &ec, size_type page)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (m_fd < 0)
+    {
+        ec = std::make_error_code(std::errc::bad_file_descriptor);
+        return {};
+    }
+    if (page >= (m_size + m_page_size - 1) / m_page_size)
+    {
+        ec = std::make_error_code(std::errc::invalid_argument);
+        return {};
+    }
+
+    std::size_t f;
+    if (!load(lock, ec, page, f))
+        return {};
+
+    size_type offset = page * m_page_size;
+    return pin(this, f, page, frame_data(f), std::min(m_page_size, m_size - offset));
+}
+
+void cy::buffer_pool::prefetch(size_type page)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_io_threads.empty() || m_page_table.contains(page))
+            return;
+        m_prefetch.push_back(page);
+    }
+    m_prefetch_ready.notify_one();
+}
+
+void cy::buffer_pool::flush(std::error_code &ec)
+{
+#if !WIN32
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (m_fd < 0)
+        return;
+
+    bool failed = false;
+    for (std::size_t f = 0; f < m_frames.size(); ++f)
+    {
+        auto &fr = m_frames[f];
+        if (!fr.used || !fr.dirty || fr.loading)
+            continue;
+
+        // Mark the frame as loading so that it is not evicted while it is written
+        fr.loading = true;
+        fr.dirty = false;
+        size_type file_size = m_size;
+        lock.unlock();
+
+        std::error_code write_ec;
+        write_page(write_ec, f, fr.page, file_size);
+
+        lock.lock();
+        fr.loading = false;
+        m_loaded.notify_all();
+        if (write_ec)
+        {
+            fr.dirty = true;
+            ec = write_ec;
+            failed = true;
+        }
+        else
+            ++m_stats.writes;
+    }
+
+    if (!failed && !m_direct && fdatasync(m_fd))
+        ec = {errno, std::generic_category()};
+#endif
+}
+
+void cy::buffer_pool::resize(std::error_code &ec, size_type new_size)
+{
+#if !WIN32
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_fd < 0)
+    {
+        ec = std::make_error_code(std::errc::bad_file_descriptor);
+        return;
+    }
+
+    size_type pages = (new_size + m_page_size - 1) / m_page_size;
+    for (auto &fr : m_frames)
+        if (fr.used && (fr.page >= pages) && (fr.pins || fr.loading))
+        {
+            ec = std::make_error_code(std::errc::device_or_resource_busy);
+            return;
+        }
+
+    if (ftruncate(m_fd, new_size))
+    {
+        ec = {errno, std::generic_category()};
+        return;
+    }
+
+    // Discard pages beyond the end, and clear the tail of the last page
+    // so that growing the file again reads zeros
+    for (std::size_t f = 0; f < m_frames.size(); ++f)
+    {
+        auto &fr = m_frames[f];
+        if (!fr.used)
+            continue;
+        if (fr.page >= pages)
+        {
+            m_page_table.erase(fr.page);
+            fr = frame();
+        }
+        else if (new_size < m_size && fr.page == pages - 1)
+        {
+            size_type used = new_size - fr.page * m_page_size;
+            std::memset(frame_data(f) + used, 0, m_page_size - used);
+        }
+    }
+
+    m_size = new_size;
+#endif
+}
+
+cy::buffer_pool::statistics cy::buffer_pool::stats() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+void cy::buffer_pool::close()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_prefetch_ready.notify_all();
+    for (auto &t : m_io_threads)
+        t.join();
+    m_io_threads.clear();
+
+    if (m_fd >= 0)
+    {
+        std::error_code ec;
+        flush(ec);
+#if !WIN32
+        ::close(m_fd);
+#endif
+        m_fd = -1;
+    }
+
+    std::free(m_memory);
+    m_memory = nullptr;
+    m_frames.clear();
+    m_page_table.clear();
+    m_prefetch.clear();
+    m_size = 0;
+    m_clock = 0;
+}
+
+void cy::buffer_pool::unpin(std::size_t f)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    assert(m_frames[f].pins > 0);
+    --m_frames[f].pins;
+}
+
+// Pins a page into a frame, reading it if necessary. The lock is released during I/O.
+// Frames that are being read or written are marked as loading, and other threads wait for them.
+
+bool cy::buffer_pool::load(std::unique_lock<std::mutex> &lock, std::error_code &ec, size_type page, std::size_t &f)
+{
+    for (;;)
+    {
+        if (auto i = m_page_table.find(page); i != m_page_table.end())
+        {
+            f = i->second;
+            auto &fr = m_frames[f];
+            if (fr.loading)
+            {
+                m_loaded.wait(lock);
+                continue;
+            }
+            ++fr.pins;
+            fr.referenced = true;
+            ++m_stats.hits;
+            return true;
+        }
+
+        if (!find_victim(f))
+        {
+            ec = std::make_error_code(std::errc::no_buffer_space);
+            return false;
+        }
+
+        auto &fr = m_frames[f];
+        if (!fr.dirty)
+            break;
+
+        // Write back the victim. It stays mapped while it is written,
+        // so that it is not read back from the file before the write completes.
+        fr.loading = true;
+        fr.dirty = false;
+        size_type file_size = m_size;
+        std::error_code write_ec;
+        lock.unlock();
+        write_page(write_ec, f, fr.page, file_size);
+        lock.lock();
+        fr.loading = false;
+        m_loaded.notify_all();
+        if (write_ec)
+        {
+            fr.dirty = true;
+            ec = write_ec;
+            return false;
+        }
+        ++m_stats.writes;
+
+        // Start again, since another thread may have loaded the page or pinned the victim
+    }
+
+    auto &fr = m_frames[f];
+    if (fr.used)
+    {
+        m_page_table.erase(fr.page);
+        ++m_stats.evictions;
+    }
+    fr.page = page;
+    fr.pins = 1;
+    fr.referenced = true;
+    fr.dirty = false;
+    fr.loading = true;
+    fr.used = true;
+    m_page_table[page] = f;
+    ++m_stats.misses;
+
+    std::error_code read_ec;
+    lock.unlock();
+    read_page(read_ec, f, page);
+    lock.lock();
+
+    fr.loading = false;
+    m_loaded.notify_all();
+    if (read_ec)
+    {
+        m_page_table.erase(page);
+        fr = frame();
+        ec = read_ec;
+        return false;
+    }
+    return true;
+}
+
+// The clock algorithm: sweep the frames, giving each referenced frame a second chance.
+
+bool cy::buffer_pool::find_victim(std::size_t &f)
+{
+    for (std::size_t n = 0; n < 2 * m_frames.size(); ++n)
+    {
+        auto &fr = m_frames[m_clock];
+        f = m_clock;
+        m_clock = (m_clock + 1) % m_frames.size();
+
+        if (!fr.used)
+            return true;
+        if (fr.pins || fr.loading)
+            continue;
+        if (fr.referenced)
+        {
+            fr.referenced = false;
+            continue;
+        }
+        return true;
+    }
+    return false;
+}
+
+void cy::buffer_pool::write_page(std::error_code &ec, std::size_t f, size_type page, size_type file_size)
+{
+#if !WIN32
+    size_type offset = page * m_page_size;
+    if (offset >= file_size)
+        return;
+
+    size_type length = std::min(m_page_size, file_size - offset);
+    if (m_direct)
+        length = (length + direct_alignment - 1) / direct_alignment * direct_alignment;
+
+    for (size_type done = 0; done < length;)
+    {
+        auto n = pwrite(m_fd, frame_data(f) + done, length - done, offset + done);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            ec = {errno, std::generic_category()};
+            return;
+        }
+        done += n;
+    }
+
+    // A direct write of the last page can extend the file
+    if (offset + length > file_size && ftruncate(m_fd, file_size))
+        ec = {errno, std::generic_category()};
+#endif
+}
+
+void cy::buffer_pool::read_page(std::error_code &ec, std::size_t f, size_type page)
+{
+#if !WIN32
+    size_type offset = page * m_page_size;
+    size_type done = 0;
+    while (done < m_page_size)
+    {
+        auto n = pread(m_fd, frame_data(f) + done, m_page_size - done, offset + done);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            ec = {errno, std::generic_category()};
+            return;
+        }
+        if (n == 0)
+            break;
+        done += n;
+    }
+
+    // Beyond the end of the file
+    std::memset(frame_data(f) + done, 0, m_page_size - done);
+#endif
+}
+
+void cy::buffer_pool::run_io()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;)
+    {
+        m_prefetch_ready.wait(lock, [this] { return m_stop || !m_prefetch.empty(); });
+        if (m_stop)
+            return;
+
+        size_type page = m_prefetch.front();
+        m_prefetch.pop_front();
+        if (page >= (m_size + m_page_size - 1) / m_page_size)
+            continue;
+
+        std::error_code ec;
+        std::size_t f;
+        if (load(lock, ec, page, f))
+            --m_frames[f].pins;
+    }
+}
@@ -0,0 +1,55 @@
+#include <cutty/file_sequence.hpp>
+
+#include <filesystem>
+
+namespace cy = cutty;
+
+namespace
+{
+// Maps a file for reading, or returns null if it is empty or could not be mapped
+std::shared_ptr<const cy::shared_memory> map_file(const char *path, std::error_code &ec)
+{
+    // Empty files cannot be mapped, but they are still valid files
+    auto size = std::filesystem::file_size(path, ec);
+    if (ec || size == 0)
+        return {};
+
+    auto memory =
+        std::make_shared<cy::shared_memory>(path, ec, cy::shared_memory::readonly | cy::shared_memory::sequential);
+    if (ec)
+        return {};
+    return memory;
+}
+
+const char *start_of(const std::shared_ptr<const cy::shared_memory> &memory)
+{
+    return memory ? static_cast<const char *>(memory->data()) : nullptr;
+}
+} // namespace
+
+cy::file_sequence::file_sequence(std::shared_ptr<const shared_memory> memory)
+    : mapped_sequence({start_of(memory), start_of(memory) + (memory ? memory->size() : 0)}, memory)
+{
+}
+
+cy::file_sequence::file_sequence(const char *path, std::error_code &ec) : file_sequence(map_file(path, ec))
+{
+}
+
+cy::file_sequence::file_sequence(const char *path) : file_sequence(seq_file(path))
+{
+}
+
+cy::file_sequence cy::seq_file(const char *path, std::error_code &ec)
+{
+    return {path, ec};
+}
+
+cy::file_sequence cy::seq_file(const char *path)
+{
+    std::error_code ec;
+    file_sequence result(path, ec);
+    if (ec)
+        throw std::system_error(ec, path);
+    return result;
+}
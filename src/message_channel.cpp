@@ -0,0 +1,294 @@
+#include <cutty/message_channel.hpp>
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace cy = cutty;
+
+namespace
+{
+const std::uint32_t channel_magic = 0x6d636831;
+
+// Marks the unused space at the end of the ring when a message does not fit
+const std::uint32_t padding_record = 0xffffffff;
+
+// Each message is preceded by an 8-byte record header containing its length,
+// and is padded to a multiple of 8 bytes.
+const cy::message_channel::size_type record_header = 8;
+
+cy::message_channel::size_type record_size(cy::message_channel::size_type size)
+{
+    return (record_header + size + 7) & ~cy::message_channel::size_type(7);
+}
+
+// Sleeps until word is no longer value, or the timeout expires.
+// The futex is not private, so it works between processes.
+void wait(std::atomic<std::uint32_t> &word, std::uint32_t value, cy::message_channel::duration timeout)
+{
+#if defined(__linux__)
+    auto secs = std::chrono::duration_cast<std::chrono::seconds>(timeout);
+    timespec ts{time_t(secs.count()), long((timeout - secs).count())};
+    syscall(SYS_futex, &word, FUTEX_WAIT, value, &ts, nullptr, 0);
+#else
+    if (word.load() == value)
+        std::this_thread::sleep_for(std::min(timeout, cy::message_channel::duration(std::chrono::microseconds(50))));
+#endif
+}
+
+void wake(std::atomic<std::uint32_t> &word)
+{
+    word.fetch_add(1, std::memory_order_release);
+#if defined(__linux__)
+    syscall(SYS_futex, &word, FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+#endif
+}
+} // namespace
+
+// The shared state at the start of the memory, followed by the ring.
+// The producer and consumer counters are on separate cache lines.
+struct cy::message_channel::header
+{
+    std::atomic<std::uint32_t> magic;
+    size_type capacity;
+
+    alignas(64) std::atomic<size_type> head; // Written by the producer
+    std::atomic<std::uint32_t> data_ready;
+    std::atomic<std::uint32_t> consumer_waiting;
+
+    alignas(64) std::atomic<size_type> tail; // Written by the consumer
+    std::atomic<std::uint32_t> space_ready;
+    std::atomic<std::uint32_t> producer_waiting;
+};
+
+namespace
+{
+const cy::message_channel::size_type header_size = 256;
+}
+
+cy::message_channel::message_channel()
+    : m_header(nullptr), m_ring(nullptr), m_reserved(0), m_padding(0), m_read(0), m_read_size(0)
+{
+    static_assert(sizeof(header) <= header_size);
+}
+
+cy::message_channel::message_channel(const char *filename, std::error_code &ec, size_type capacity, int flags)
+    : message_channel()
+{
+    capacity = std::bit_ceil(std::max<size_type>(capacity, 4096));
+    m_memory = shared_memory(filename, ec, flags, header_size + capacity);
+    if (m_memory)
+        open(ec, capacity);
+}
+
+cy::message_channel::message_channel(shared_memory &&memory, std::error_code &ec, size_type capacity)
+    : message_channel()
+{
+    m_memory = std::move(memory);
+    if (m_memory)
+        open(ec, std::bit_ceil(std::max<size_type>(capacity, 4096)));
+}
+
+void cy::message_channel::open(std::error_code &ec, size_type capacity)
+{
+    if (m_memory.size() < header_size)
+    {
+        m_memory.resize(ec, header_size + capacity);
+        if (ec || !m_memory)
+            return;
+    }
+
+    auto h = (header *)m_memory.data();
+    if (h->magic.load(std::memory_order_acquire) != channel_magic)
+    {
+        // A new channel
+        if (m_memory.size() < header_size + capacity)
+        {
+            m_memory.resize(ec, header_size + capacity);
+            if (ec || !m_memory)
+                return;
+            h = (header *)m_memory.data();
+        }
+        h->capacity = capacity;
+        h->head.store(0, std::memory_order_relaxed);
+        h->tail.store(0, std::memory_order_relaxed);
+        h->magic.store(channel_magic, std::memory_order_release);
+    }
+    else if (m_memory.size() < header_size + h->capacity || !std::has_single_bit(h->capacity))
+    {
+        ec = std::make_error_code(std::errc::invalid_argument);
+        m_memory.close();
+        return;
+    }
+
+    m_header = h;
+    m_ring = (std::byte *)m_memory.data() + header_size;
+}
+
+cy::message_channel::size_type cy::message_channel::capacity() const
+{
+    return m_header ? m_header->capacity : 0;
+}
+
+cy::message_channel::size_type cy::message_channel::max_message_size() const
+{
+    return m_header ? m_header->capacity / 2 - record_header : 0;
+}
+
+std::span<std::byte> cy::message_channel::reserve(size_type size)
+{
+    if (!m_header || size > max_message_size())
+        return {};
+
+    auto capacity = m_header->capacity;
+    auto head = m_header->head.load(std::memory_order_relaxed);
+    auto tail = m_header->tail.load(std::memory_order_acquire);
+
+    // Messages are contiguous, so skip the end of the ring if the message does not fit
+    auto rec = record_size(size);
+    auto offset = head & (capacity - 1);
+    size_type padding = offset + rec > capacity ? capacity - offset : 0;
+
+    if (head + padding + rec - tail > capacity)
+        return {};
+
+    if (padding)
+        std::memcpy(m_ring + offset, &padding_record, sizeof padding_record);
+
+    m_reserved = size;
+    m_padding = padding;
+    return {m_ring + ((head + padding) & (capacity - 1)) + record_header, std::size_t(size)};
+}
+
+std::span<std::byte> cy::message_channel::reserve(size_type size, duration timeout)
+{
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    for (;;)
+    {
+        auto result = reserve(size);
+        if (result.data() || !m_header || size > max_message_size())
+            return result;
+
+        auto now = std::chrono::steady_clock::now();
+        if (now >= deadline)
+            return result;
+
+        // Check again after announcing that we are waiting, so that a release() is not missed
+        auto seq = m_header->space_ready.load(std::memory_order_acquire);
+        m_header->producer_waiting.store(1);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        result = reserve(size);
+        if (!result.data())
+            wait(m_header->space_ready, seq, deadline - now);
+        m_header->producer_waiting.store(0, std::memory_order_relaxed);
+
+        if (result.data())
+            return result;
+    }
+}
+
+void cy::message_channel::commit(size_type size)
+{
+    assert(size <= m_reserved);
+
+    auto capacity = m_header->capacity;
+    auto head = m_header->head.load(std::memory_order_relaxed) + m_padding;
+    auto length = std::uint32_t(size);
+    std::memcpy(m_ring + (head & (capacity - 1)), &length, sizeof length);
+    m_header->head.store(head + record_size(size), std::memory_order_release);
+    m_reserved = 0;
+    m_padding = 0;
+
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_header->consumer_waiting.load(std::memory_order_relaxed))
+        wake(m_header->data_ready);
+}
+
+bool cy::message_channel::try_send(std::span<const std::byte> message)
+{
+    auto buffer = reserve(message.size());
+    if (!buffer.data())
+        return false;
+    std::memcpy(buffer.data(), message.data(), message.size());
+    commit(message.size());
+    return true;
+}
+
+std::span<const std::byte> cy::message_channel::read()
+{
+    if (!m_header)
+        return {};
+
+    auto capacity = m_header->capacity;
+    auto tail = m_header->tail.load(std::memory_order_relaxed);
+    auto head = m_header->head.load(std::memory_order_acquire);
+    if (tail == head)
+        return {};
+
+    auto offset = tail & (capacity - 1);
+    std::uint32_t length;
+    std::memcpy(&length, m_ring + offset, sizeof length);
+    if (length == padding_record)
+    {
+        tail += capacity - offset;
+        offset = 0;
+        std::memcpy(&length, m_ring, sizeof length);
+    }
+
+    m_read = tail;
+    m_read_size = length;
+    return {m_ring + offset + record_header, length};
+}
+
+std::span<const std::byte> cy::message_channel::read(duration timeout)
+{
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    for (;;)
+    {
+        auto result = read();
+        if (result.data() || !m_header)
+            return result;
+
+        auto now = std::chrono::steady_clock::now();
+        if (now >= deadline)
+            return result;
+
+        // Check again after announcing that we are waiting, so that a commit() is not missed
+        auto seq = m_header->data_ready.load(std::memory_order_acquire);
+        m_header->consumer_waiting.store(1);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        result = read();
+        if (!result.data())
+            wait(m_header->data_ready, seq, deadline - now);
+        m_header->consumer_waiting.store(0, std::memory_order_relaxed);
+
+        if (result.data())
+            return result;
+    }
+}
+
+void cy::message_channel::release()
+{
+    m_header->tail.store(m_read + record_size(m_read_size), std::memory_order_release);
+
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_header->producer_waiting.load(std::memory_order_relaxed))
+        wake(m_header->space_ready);
+}
+
+cy::message_channel::size_type cy::message_channel::pending() const
+{
+    if (!m_header)
+        return 0;
+    return m_header->head.load(std::memory_order_acquire) - m_header->tail.load(std::memory_order_acquire);
+}
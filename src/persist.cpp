@@ -73,6 +73,23 @@ inline int object_cell(size_t &req_size)
 }
 
 
+// cell_size
+//
+// The inverse of object_cell: returns the size of blocks in the given cell.
+
+inline size_t cell_size(int cell)
+{
+    size_t size = sizeof(void*);
+    for(int i=0; i<cell; i+=2)
+    {
+        size_t s0 = size>>1;
+        if(i+1 == cell) return size + s0;
+        size += 2*s0;
+    }
+    return size;
+}
+
+
 // map_file::malloc
 //
 // Allocates an object of size @size from the shared memory
@@ -248,13 +265,15 @@ cy::map_file::map_file(const char *filename, int applicationId, short majorVersi
     open(filename, applicationId, majorVersion, minorVersion, length, limit, flags, base);
 }
 
+cy::map_file::map_file(shared_memory &&memory, int applicationId, short majorVersion, short minorVersion, size_t limit)
+{
+    open(std::move(memory), applicationId, majorVersion, minorVersion, limit);
+}
+
 void cy::map_file::open(const char *filename,  int applicationId, short majorVersion, short minorVersion, size_t length, size_t limit, int flags, size_t base)
 {
     close();
-    
-    const int persistMagic = 0x99a10f0f;
-    const int hardwareId = 0x00000001;
-    
+
     std::error_code ec;
     int sh_flags = 0;
     if (flags & create_new)
@@ -265,8 +284,31 @@ void cy::map_file::open(const char *filename,  int applicationId, short majorVer
     {
         sh_flags = shared_memory::create;
     }
+    if (flags & huge_pages) sh_flags |= shared_memory::huge_pages;
+    if (flags & sequential_access) sh_flags |= shared_memory::sequential;
+    if (flags & random_access) sh_flags |= shared_memory::random;
+    if (flags & prefault) sh_flags |= shared_memory::prefault;
+    if (flags & preallocate) sh_flags |= shared_memory::preallocate;
     shared_memory mem(filename, ec, sh_flags, length, (void*)base);
 
+    open(std::move(mem), applicationId, majorVersion, minorVersion, limit);
+}
+
+
+// map_file::open
+//
+// Opens a heap in memory that has already been mapped, for example
+// anonymous memory received from another process.
+
+void cy::map_file::open(shared_memory &&mem, int applicationId, short majorVersion, short minorVersion, size_t limit)
+{
+    close();
+
+    const int persistMagic = 0x99a10f0f;
+    const int hardwareId = 0x00000001;
+
+    std::error_code ec;
+    size_t length = mem.size();
     detail::shared_record *map_address = (detail::shared_record*)mem.data();
 
     if(mem)
@@ -274,12 +316,11 @@ void cy::map_file::open(const char *filename,  int applicationId, short majorVer
         // Remap the file according to the specifications in the header file
 
         void *previous_address = map_address->address;
-        size_t previous_length = map_address->current_size;
-        
-        if(previous_address && (previous_length != length || previous_address != map_address))
+
+        if(previous_address && previous_address != map_address)
         {
             mem.reopen_at(ec, previous_address);
-            detail::shared_record *map_address = (detail::shared_record*)mem.data();
+            map_address = (detail::shared_record*)mem.data();
         }
     }
 
@@ -366,6 +407,7 @@ bool cy::map_file::extend_to(void * new_top)
     memory.reserve(ec, new_length-1);  // ?? Should we try to recover?
 
     if(!memory) return false;  // Catastrophe
+    if(memory.size() < new_length-1) return false;  // The file could not be extended, e.g. disk full
 
     assert(memory.data() == (char*)&d);
     data().current_size = new_length;
@@ -374,6 +416,83 @@ bool cy::map_file::extend_to(void * new_top)
 }
 
 
+// map_file::trim
+//
+// Any free block that ends at the top of the heap is removed from its free list
+// and the top is lowered, until no such block remains.
+// The file is then truncated to the (page-aligned) top of the heap.
+
+size_t cy::map_file::trim()
+{
+    auto &d = data();
+    d.lockMem();
+
+    bool found = true;
+    while(found)
+    {
+        found = false;
+        for(int cell=0; cell<64; ++cell)
+        {
+            size_t size = cell_size(cell);
+            for(void **prev = &d.free_space[cell]; *prev; )
+            {
+                char *block = (char*)*prev;
+                if(block + size == d.top)
+                {
+                    *prev = *(void**)block;
+                    d.top = block;
+                    found = true;
+                }
+                else
+                {
+                    prev = (void**)block;
+                }
+            }
+        }
+    }
+
+    const size_t page_size = shared_memory::page_size();
+    size_t old_length = d.current_size;
+    size_t new_length = ((d.top - (char*)&d) + page_size - 1) & ~(page_size - 1);
+
+    if(new_length < old_length)
+    {
+        std::error_code ec;
+        memory.resize(ec, new_length);
+        if(!memory)
+        {
+            // Catastrophe - the heap is no longer mapped, and its mutex went with it.
+            // This can only happen on platforms without mremap(), which unmap before remapping.
+            return 0;
+        }
+        assert(memory.data() == (char*)&d);
+        if(ec)
+        {
+            // The file or mapping could not be shrunk, so the heap keeps its old length.
+            // If only the mapping failed, this restores the length of the file.
+            memory.resize(ec, old_length);
+            new_length = old_length;
+        }
+        else
+        {
+            d.current_size = new_length;
+            d.end = (char*)&d + new_length;
+        }
+    }
+
+    d.unlockMem();
+    return new_length < old_length ? old_length - new_length : 0;
+}
+
+
+void cy::map_file::advise(std::error_code &ec, const void *address, size_t length, shared_memory::hint h)
+{
+    size_t offset = (const char*)address - (const char*)memory.data();
+    if(offset >= memory.size()) return;  // Not in this heap
+    memory.advise(ec, offset, length, h);
+}
+
+
 bool cy::detail::shared_record::lock(int ms)
 {
     extra.user_mutex.lock();
@@ -0,0 +1,105 @@
+#include <cutty/persist/sharded_map_file.hpp>
+
+#include <atomic>
+
+namespace cy = cutty;
+
+namespace
+{
+std::atomic<unsigned> next_domain;
+
+unsigned &current_domain()
+{
+    thread_local unsigned domain = next_domain++;
+    return domain;
+}
+} // namespace
+
+cy::persist::sharded_map_file::sharded_map_file()
+{
+}
+
+cy::persist::sharded_map_file::sharded_map_file(const std::vector<std::string> &filenames, int applicationId,
+                                                short majorVersion, short minorVersion, size_t length, size_t limit,
+                                                int flags, size_t base, size_t stride)
+{
+    open(filenames, applicationId, majorVersion, minorVersion, length, limit, flags, base, stride);
+}
+
+void cy::persist::sharded_map_file::open(const std::vector<std::string> &filenames, int applicationId,
+                                         short majorVersion, short minorVersion, size_t length, size_t limit,
+                                         int flags, size_t base, size_t stride)
+{
+    close();
+
+    if (filenames.empty())
+        throw std::invalid_argument("sharded_map_file needs at least one segment");
+    if (limit > stride)
+        throw std::invalid_argument("sharded_map_file segment limit exceeds stride");
+
+    for (size_t i = 0; i < filenames.size(); ++i)
+    {
+        auto segment = std::make_unique<map_file>(filenames[i].c_str(), applicationId, majorVersion, minorVersion,
+                                                  length, limit, flags, base + i * stride);
+        if (!*segment)
+        {
+            close();
+            return;
+        }
+        segments.push_back(std::move(segment));
+    }
+}
+
+void cy::persist::sharded_map_file::close()
+{
+    segments.clear();
+}
+
+std::vector<std::string> cy::persist::sharded_map_file::segment_names(const std::string &prefix, int count)
+{
+    std::vector<std::string> result;
+    for (int i = 0; i < count; ++i)
+        result.push_back(prefix + "." + std::to_string(i));
+    return result;
+}
+
+cy::persist::sharded_map_file::operator bool() const
+{
+    return !segments.empty();
+}
+
+unsigned cy::persist::sharded_map_file::thread_domain()
+{
+    return current_domain();
+}
+
+void cy::persist::sharded_map_file::thread_domain(unsigned domain)
+{
+    current_domain() = domain;
+}
+
+int cy::persist::sharded_map_file::segment_of(const void *p) const
+{
+    for (size_t i = 0; i < segments.size(); ++i)
+    {
+        auto &d = segments[i]->data();
+        if (p >= (const void *)&d && p < (const void *)((const char *)&d + d.limit()))
+            return int(i);
+    }
+    return -1;
+}
+
+void cy::persist::sharded_map_file::free(void *p, size_t size)
+{
+    int s = segment_of(p);
+    if (s >= 0)
+        segments[s]->free(p, size);
+}
+
+size_t cy::persist::sharded_map_file::capacity() const
+{
+    size_t result = 0;
+    for (auto &s : segments)
+        result += s->capacity();
+    return result;
+}
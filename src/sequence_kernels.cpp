@@ -0,0 +1,163 @@
+#include <cutty/sequence.hpp>
+
+namespace cy = cutty;
+
+// Compile each kernel for AVX-512 and AVX2 as well as the baseline, and select one
+// at load time. This needs ifunc support, so is limited to x86-64 Linux.
+#if defined(__x86_64__) && defined(__linux__) && (defined(__GNUC__) || defined(__clang__))
+#define CUTTY_TARGET_CLONES __attribute__((target_clones("avx512f", "avx2", "default")))
+#else
+#define CUTTY_TARGET_CLONES
+#endif
+
+namespace
+{
+// The number of independent accumulators, which lets the compiler use vector registers
+// without reassociating floating point additions itself.
+constexpr std::size_t lanes = 16;
+
+// The block size for pairwise summation. Blocks are summed with lanes, and blocks are combined pairwise.
+constexpr std::size_t block_size = 256;
+
+template <typename T> inline T sum_block(const T *data, std::size_t size)
+{
+    T acc[lanes] = {};
+    std::size_t i = 0;
+    for (; i + lanes <= size; i += lanes)
+        for (std::size_t j = 0; j < lanes; ++j)
+            acc[j] += data[i + j];
+    for (; i < size; ++i)
+        acc[0] += data[i];
+
+    for (std::size_t width = lanes / 2; width > 0; width /= 2)
+        for (std::size_t j = 0; j < width; ++j)
+            acc[j] += acc[j + width];
+    return acc[0];
+}
+
+template <typename T> inline T sum(const T *data, std::size_t size)
+{
+    if constexpr (std::is_floating_point_v<T>)
+    {
+        if (size <= block_size)
+            return sum_block(data, size);
+        std::size_t half = size / 2 / block_size * block_size;
+        if (!half)
+            half = block_size;
+        return sum(data, half) + sum(data + half, size - half);
+    }
+    else
+        return sum_block(data, size);
+}
+
+template <typename T> inline T dot_block(const T *a, const T *b, std::size_t size)
+{
+    T acc[lanes] = {};
+    std::size_t i = 0;
+    for (; i + lanes <= size; i += lanes)
+        for (std::size_t j = 0; j < lanes; ++j)
+            acc[j] += a[i + j] * b[i + j];
+    for (; i < size; ++i)
+        acc[0] += a[i] * b[i];
+
+    for (std::size_t width = lanes / 2; width > 0; width /= 2)
+        for (std::size_t j = 0; j < width; ++j)
+            acc[j] += acc[j + width];
+    return acc[0];
+}
+
+template <typename T> inline T dot(const T *a, const T *b, std::size_t size)
+{
+    if constexpr (std::is_floating_point_v<T>)
+    {
+        if (size <= block_size)
+            return dot_block(a, b, size);
+        std::size_t half = size / 2 / block_size * block_size;
+        if (!half)
+            half = block_size;
+        return dot(a, b, half) + dot(a + half, b + half, size - half);
+    }
+    else
+        return dot_block(a, b, size);
+}
+
+// Each lane keeps its own minimum or maximum, so the compiler can use vector instructions.
+// size must not be 0.
+
+template <typename T, typename Less> inline T extreme(const T *data, std::size_t size, Less less)
+{
+    T acc[lanes];
+    for (std::size_t j = 0; j < lanes; ++j)
+        acc[j] = data[0];
+
+    std::size_t i = 0;
+    for (; i + lanes <= size; i += lanes)
+        for (std::size_t j = 0; j < lanes; ++j)
+            acc[j] = less(data[i + j], acc[j]) ? data[i + j] : acc[j];
+    for (; i < size; ++i)
+        acc[0] = less(data[i], acc[0]) ? data[i] : acc[0];
+
+    for (std::size_t j = 1; j < lanes; ++j)
+        acc[0] = less(acc[j], acc[0]) ? acc[j] : acc[0];
+    return acc[0];
+}
+
+template <typename T> inline T min(const T *data, std::size_t size)
+{
+    return extreme(data, size, [](T a, T b) { return a < b; });
+}
+
+template <typename T> inline T max(const T *data, std::size_t size)
+{
+    return extreme(data, size, [](T a, T b) { return b < a; });
+}
+
+// Compares in blocks to avoid a branch per element
+template <typename T> inline bool equal(const T *a, const T *b, std::size_t size)
+{
+    std::size_t i = 0;
+    for (; i + lanes <= size; i += lanes)
+    {
+        bool same = true;
+        for (std::size_t j = 0; j < lanes; ++j)
+            same &= a[i + j] == b[i + j];
+        if (!same)
+            return false;
+    }
+    for (; i < size; ++i)
+        if (!(a[i] == b[i]))
+            return false;
+    return true;
+}
+} // namespace
+
+#define CUTTY_SEQUENCE_KERNELS(T)                                                                                      \
+    CUTTY_TARGET_CLONES T cy::sequences::kernels::sum(const T *data, std::size_t size)                                 \
+    {                                                                                                                  \
+        return ::sum(data, size);                                                                                      \
+    }                                                                                                                  \
+    CUTTY_TARGET_CLONES T cy::sequences::kernels::min(const T *data, std::size_t size)                                 \
+    {                                                                                                                  \
+        return ::min(data, size);                                                                                      \
+    }                                                                                                                  \
+    CUTTY_TARGET_CLONES T cy::sequences::kernels::max(const T *data, std::size_t size)                                 \
+    {                                                                                                                  \
+        return ::max(data, size);                                                                                      \
+    }                                                                                                                  \
+    CUTTY_TARGET_CLONES T cy::sequences::kernels::dot(const T *a, const T *b, std::size_t size)                        \
+    {                                                                                                                  \
+        return ::dot(a, b, size);                                                                                      \
+    }                                                                                                                  \
+    CUTTY_TARGET_CLONES bool cy::sequences::kernels::equal(const T *a, const T *b, std::size_t size)                   \
+    {                                                                                                                  \
+        return ::equal(a, b, size);                                                                                    \
+    }
+
+CUTTY_SEQUENCE_KERNELS(int)
+CUTTY_SEQUENCE_KERNELS(unsigned)
+CUTTY_SEQUENCE_KERNELS(long)
+CUTTY_SEQUENCE_KERNELS(unsigned long)
+CUTTY_SEQUENCE_KERNELS(long long)
+CUTTY_SEQUENCE_KERNELS(unsigned long long)
+CUTTY_SEQUENCE_KERNELS(float)
+CUTTY_SEQUENCE_KERNELS(double)
@@ -15,13 +15,68 @@
 #else
 #include <fcntl.h>
 #include <sys/mman.h>
+#include <sys/socket.h>
 #include <sys/stat.h>
 #include <unistd.h>
 #endif
 
+#include <atomic>
+#include <cstring>
+#include <string>
+
 namespace cy = cutty;
 
-cy::shared_memory::shared_memory() : m_data(0), m_size(0), m_fd(-1)
+#if !WIN32
+namespace
+{
+// Sets the size of a file. When growing with preallocate, the new blocks are allocated
+// on disk now, so that running out of space is reported here rather than by SIGBUS later.
+// Returns an error number, or 0 on success.
+int set_file_size(int fd, cy::shared_memory::size_type old_size, cy::shared_memory::size_type new_size, bool preallocate,
+                  cy::shared_memory::size_type chunk)
+{
+    if (!preallocate || new_size <= old_size)
+        return ftruncate(fd, new_size) ? errno : 0;
+
+    if (int err = posix_fallocate(fd, old_size, new_size - old_size))
+        return err;
+
+#if defined(__linux__) && defined(FALLOC_FL_KEEP_SIZE)
+    if (chunk)
+    {
+        // Reserve blocks up to the next chunk boundary, without changing the file size.
+        // This is only an optimization, so failure is not an error.
+        auto chunk_end = (new_size + chunk - 1) / chunk * chunk;
+        if (chunk_end > new_size)
+            fallocate(fd, FALLOC_FL_KEEP_SIZE, new_size, chunk_end - new_size);
+    }
+#endif
+    return 0;
+}
+
+// Maps a file twice, back to back, so that accesses that run off the end of the
+// first copy continue at the start of the file. Returns MAP_FAILED on failure.
+void *map_twice(int fd, cy::shared_memory::size_type size, int prot, void *hint)
+{
+    // Reserve the address space for both copies, then replace it with the file
+    auto base = (char *)mmap(hint, 2 * size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED)
+        return MAP_FAILED;
+
+    if (mmap(base, size, prot, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED ||
+        mmap(base + size, size, prot, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED)
+    {
+        int err = errno;
+        munmap(base, 2 * size);
+        errno = err;
+        return MAP_FAILED;
+    }
+    return base;
+}
+} // namespace
+#endif
+
+cy::shared_memory::shared_memory() : m_data(0), m_size(0), m_fd(-1), m_flags(0), m_growth_chunk(0)
 {
 #if WIN32
     m_map_handle = INVALID_HANDLE_VALUE;
@@ -39,6 +94,8 @@ cy::shared_memory &cy::shared_memory::operator=(cy::shared_memory &&src)
     m_map_handle = src.m_map_handle;
     m_file_handle = src.m_file_handle;
     m_map_flags = src.m_map_flags;
+    m_flags = src.m_flags;
+    m_growth_chunk = src.m_growth_chunk;
 
     src.m_data = 0;
     src.m_size = 0;
@@ -69,7 +126,7 @@ void cy::shared_memory::close()
         m_map_handle = INVALID_HANDLE_VALUE;
 #else
         msync(m_data, m_size, MS_SYNC);
-        munmap(m_data, m_size);
+        munmap(m_data, m_flags & ring ? 2 * m_size : m_size);
         ::close(m_fd);
 #endif
         m_data = 0;
@@ -83,6 +140,11 @@ cy::shared_memory::shared_memory(const char *filename, std::error_code &ec, int
     : shared_memory()
 {
 #if WIN32
+    if (flags & ring)
+    {
+        ec = std::make_error_code(std::errc::function_not_supported);
+        return;
+    }
 
     int open_flags = (flags & trunc) ? CREATE_ALWAYS : OPEN_ALWAYS;
 
@@ -138,6 +200,8 @@ cy::shared_memory::shared_memory(const char *filename, std::error_code &ec, int
     m_size = initial_size;
     m_file_handle = hFile;
     m_map_handle = hMapFile;
+    m_flags = flags;
+    apply_flags();
 
 #else
     int fd_flags = 0;
@@ -152,10 +216,33 @@ cy::shared_memory::shared_memory(const char *filename, std::error_code &ec, int
     if (flags & trunc)
         fd_flags |= O_TRUNC;
 
-    int fd = -1;
-    size_type mapped_size = initial_size;
+    int fd = open(filename, fd_flags, 0600); // ?? Permissions
 
-    fd = open(filename, fd_flags, 0600); // ?? Permissions
+    if (fd < 0)
+    {
+        ec = {errno, std::generic_category()};
+        return;
+    }
+
+    map(ec, fd, flags, initial_size, hint);
+#endif
+}
+
+cy::shared_memory::shared_memory(std::error_code &ec, size_type size, int flags, void *hint) : shared_memory()
+{
+#if WIN32
+    ec = std::make_error_code(std::errc::function_not_supported);
+#else
+#if defined(__linux__)
+    int fd = memfd_create("cutty", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+#else
+    // Create a POSIX shared memory object, then unlink it so that it has no name
+    static std::atomic<int> counter;
+    auto name = "/cutty-" + std::to_string(getpid()) + "-" + std::to_string(counter++);
+    int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd >= 0)
+        shm_unlink(name.c_str());
+#endif
 
     if (fd < 0)
     {
@@ -163,16 +250,60 @@ cy::shared_memory::shared_memory(const char *filename, std::error_code &ec, int
         return;
     }
 
+    map(ec, fd, flags & ~readonly, size, hint);
+
+    if (m_data && (flags & sealed))
+    {
+        seal(ec);
+        if (ec)
+            close();
+    }
+#endif
+}
+
+cy::shared_memory::shared_memory(int fd, std::error_code &ec, int flags, void *hint) : shared_memory()
+{
+#if WIN32
+    ec = std::make_error_code(std::errc::function_not_supported);
+#else
+    map(ec, fd, flags, 0, hint);
+#endif
+}
+
+cy::shared_memory::shared_memory(shared_memory &&src) : shared_memory()
+{
+    *this = std::move(src);
+}
+
+void cy::shared_memory::swap(shared_memory &other)
+{
+    std::swap(m_data, other.m_data);
+    std::swap(m_size, other.m_size);
+    std::swap(m_fd, other.m_fd);
+    std::swap(m_file_handle, other.m_file_handle);
+    std::swap(m_map_handle, other.m_map_handle);
+    std::swap(m_map_flags, other.m_map_flags);
+    std::swap(m_flags, other.m_flags);
+    std::swap(m_growth_chunk, other.m_growth_chunk);
+}
+
+#if !WIN32
+// Maps an open file, extending it to initial_size if necessary.
+// Takes ownership of fd, which is closed on failure.
+void cy::shared_memory::map(std::error_code &ec, int fd, int flags, size_type initial_size, void *hint)
+{
+    size_type mapped_size = initial_size;
+
     struct stat st;
     fstat(fd, &st);
     mapped_size = st.st_size;
 
     if (mapped_size < initial_size)
     {
-        if (ftruncate(fd, initial_size))
+        if (int err = set_file_size(fd, mapped_size, initial_size, flags & preallocate, m_growth_chunk))
         {
             // resize failed
-            ec = {errno, std::generic_category()};
+            ec = {err, std::generic_category()};
             ::close(fd);
             return;
         }
@@ -184,7 +315,27 @@ cy::shared_memory::shared_memory(const char *filename, std::error_code &ec, int
 
     if(!hint) hint = (void*)DEFAULT_ADDRESS;
 
-    auto data = mmap(hint, mapped_size, prot_flags, m_map_flags, fd, 0);
+    int populate = 0;
+#if defined(MAP_POPULATE)
+    if (flags & prefault)
+        populate = MAP_POPULATE;
+#endif
+
+    void *data;
+    if (flags & ring)
+    {
+        if (mapped_size == 0 || mapped_size % sysconf(_SC_PAGESIZE))
+        {
+            ec = std::make_error_code(std::errc::invalid_argument);
+            ::close(fd);
+            return;
+        }
+        data = map_twice(fd, mapped_size, prot_flags, hint);
+    }
+    else
+    {
+        data = mmap(hint, mapped_size, prot_flags, m_map_flags | populate, fd, 0);
+    }
 
     if (data == MAP_FAILED)
     {
@@ -197,6 +348,263 @@ cy::shared_memory::shared_memory(const char *filename, std::error_code &ec, int
     m_fd = fd;
     m_size = mapped_size;
     m_data = data;
+    m_flags = flags;
+    apply_flags();
+}
+#endif
+
+// Applies the access hints in m_flags to the whole mapping.
+// The hints are advisory, so errors are ignored.
+void cy::shared_memory::apply_flags()
+{
+    std::error_code ec;
+    if (m_flags & huge_pages)
+        advise(ec, 0, 0, hint::huge_pages);
+    if (m_flags & sequential)
+        advise(ec, 0, 0, hint::sequential);
+    else if (m_flags & random)
+        advise(ec, 0, 0, hint::random);
+#if !defined(MAP_POPULATE)
+    if (m_flags & prefault)
+        advise(ec, 0, 0, hint::willneed);
+#endif
+}
+
+void cy::shared_memory::advise(std::error_code &ec, size_type offset, size_type length, hint h)
+{
+    if (!m_data || offset >= m_size)
+        return;
+    if (length == 0 || length > m_size - offset)
+        length = m_size - offset;
+
+#if WIN32
+    if (h == hint::willneed)
+    {
+        WIN32_MEMORY_RANGE_ENTRY range{(char *)m_data + offset, length};
+        if (!PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0))
+            ec = {int(GetLastError()), std::system_category()};
+    }
+#else
+    int advice;
+    switch (h)
+    {
+    case hint::normal:
+        advice = MADV_NORMAL;
+        break;
+    case hint::sequential:
+        advice = MADV_SEQUENTIAL;
+        break;
+    case hint::random:
+        advice = MADV_RANDOM;
+        break;
+    case hint::willneed:
+        advice = MADV_WILLNEED;
+        break;
+    case hint::dontneed:
+        advice = MADV_DONTNEED;
+        break;
+    case hint::cold:
+#if defined(MADV_COLD)
+        advice = MADV_COLD;
+        break;
+#else
+        return;
+#endif
+    case hint::huge_pages:
+#if defined(MADV_HUGEPAGE)
+        advice = MADV_HUGEPAGE;
+        break;
+#else
+        return;
+#endif
+    default:
+        return;
+    }
+
+    // madvise needs a page-aligned address
+    size_type page_size = sysconf(_SC_PAGESIZE);
+    size_type start = offset & ~(page_size - 1);
+    if (madvise((char *)m_data + start, length + (offset - start), advice))
+        ec = {errno, std::generic_category()};
+#endif
+}
+
+cy::shared_memory::page_residency cy::shared_memory::residency(std::error_code &ec, size_type offset,
+                                                               size_type length) const
+{
+    page_residency result;
+    if (!m_data || offset >= m_size)
+        return result;
+    if (length == 0 || length > m_size - offset)
+        length = m_size - offset;
+
+#if WIN32
+    ec = std::make_error_code(std::errc::function_not_supported);
+#else
+    result.page_size = sysconf(_SC_PAGESIZE);
+    size_type start = offset & ~(result.page_size - 1);
+    length += offset - start;
+    size_type page_count = (length + result.page_size - 1) / result.page_size;
+
+#if defined(__APPLE__)
+    std::vector<char> vec(page_count);
+#else
+    std::vector<unsigned char> vec(page_count);
+#endif
+    if (mincore((char *)m_data + start, length, vec.data()))
+    {
+        ec = {errno, std::generic_category()};
+        return result;
+    }
+
+    result.pages.resize(page_count);
+    for (size_type i = 0; i < page_count; ++i)
+    {
+        if (vec[i] & 1)
+        {
+            result.pages[i] = true;
+            ++result.resident_pages;
+        }
+    }
+#endif
+    return result;
+}
+
+void cy::shared_memory::prefetch(std::error_code &ec, size_type offset, size_type length)
+{
+    advise(ec, offset, length, hint::willneed);
+}
+
+void cy::shared_memory::evict(std::error_code &ec, size_type offset, size_type length, bool drop)
+{
+#if WIN32
+    if (!m_data || offset >= m_size)
+        return;
+    if (length == 0 || length > m_size - offset)
+        length = m_size - offset;
+
+    // Unlocking pages that are not locked removes them from the working set
+    VirtualUnlock((char *)m_data + offset, length);
+#elif defined(MADV_COLD)
+    if (drop)
+    {
+        advise(ec, offset, length, hint::dontneed);
+    }
+    else
+    {
+        advise(ec, offset, length, hint::cold);
+
+        // MADV_COLD needs Linux 5.4
+        if (ec == std::errc::invalid_argument)
+        {
+            ec.clear();
+            advise(ec, offset, length, hint::dontneed);
+        }
+    }
+#else
+    // For shared mappings, MADV_DONTNEED does not lose data
+    advise(ec, offset, length, hint::dontneed);
+#endif
+}
+
+void cy::shared_memory::flush(std::error_code &ec, size_type offset, size_type length, bool sync)
+{
+    if (!m_data || offset >= m_size)
+        return;
+    if (length == 0 || length > m_size - offset)
+        length = m_size - offset;
+
+#if WIN32
+    if (!FlushViewOfFile((char *)m_data + offset, length) || (sync && !FlushFileBuffers(m_file_handle)))
+        ec = {int(GetLastError()), std::system_category()};
+#else
+    size_type page_size = sysconf(_SC_PAGESIZE);
+    size_type start = offset & ~(page_size - 1);
+    length += offset - start;
+
+#if defined(__linux__)
+    if (!sync)
+    {
+        // msync(MS_ASYNC) does nothing on Linux, so start writeback explicitly
+        if (sync_file_range(m_fd, start, length, SYNC_FILE_RANGE_WRITE))
+            ec = {errno, std::generic_category()};
+        return;
+    }
+#endif
+    if (msync((char *)m_data + start, length, sync ? MS_SYNC : MS_ASYNC))
+        ec = {errno, std::generic_category()};
+#endif
+}
+
+void cy::shared_memory::seal(std::error_code &ec)
+{
+#if defined(__linux__)
+    if (fcntl(m_fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL))
+        ec = {errno, std::generic_category()};
+#else
+    ec = std::make_error_code(std::errc::function_not_supported);
+#endif
+}
+
+void cy::send_fd(std::error_code &ec, int socket, int fd)
+{
+#if WIN32
+    ec = std::make_error_code(std::errc::function_not_supported);
+#else
+    char byte = 0;
+    iovec iov{&byte, 1};
+
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))] = {};
+    msghdr msg = {};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    auto cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+    std::memcpy(CMSG_DATA(cmsg), &fd, sizeof(int));
+
+    if (sendmsg(socket, &msg, 0) < 0)
+        ec = {errno, std::generic_category()};
+#endif
+}
+
+int cy::receive_fd(std::error_code &ec, int socket)
+{
+#if WIN32
+    ec = std::make_error_code(std::errc::function_not_supported);
+    return -1;
+#else
+    char byte;
+    iovec iov{&byte, 1};
+
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))] = {};
+    msghdr msg = {};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    auto n = recvmsg(socket, &msg, 0);
+    if (n < 0)
+    {
+        ec = {errno, std::generic_category()};
+        return -1;
+    }
+
+    auto cmsg = CMSG_FIRSTHDR(&msg);
+    if (n == 0 || !cmsg || cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS)
+    {
+        ec = std::make_error_code(std::errc::bad_message);
+        return -1;
+    }
+
+    int fd;
+    std::memcpy(&fd, CMSG_DATA(cmsg), sizeof(int));
+    return fd;
 #endif
 }
 
@@ -236,6 +644,12 @@ void cy::shared_memory::remap(std::error_code &ec, size_type mapped_size)
 
 #else
 
+        if (m_flags & ring)
+        {
+            remap_ring(ec, mapped_size, m_data);
+            return;
+        }
+
 #if HAVE_MREMAP
         auto data = mremap(m_data, m_size, mapped_size, MREMAP_MAYMOVE, 0);
 #else
@@ -249,13 +663,75 @@ void cy::shared_memory::remap(std::error_code &ec, size_type mapped_size)
         {
             ec = {errno, std::generic_category()};
             print(ec.message());
+#if !HAVE_MREMAP
+            // A failed mremap() leaves the original mapping in place, so only close if it has gone
             close();
+#endif
             return;
         }
         m_data = data;
         m_size = mapped_size;
+        apply_flags();
+#endif
+    }
+}
+
+#if !WIN32
+// Replaces the double mapping of a ring with one of a new size, at or near the given address.
+void cy::shared_memory::remap_ring(std::error_code &ec, size_type new_size, void *address)
+{
+    munmap(m_data, 2 * m_size);
+    m_data = 0;
+
+    void *data = MAP_FAILED;
+    if (new_size == 0 || new_size % sysconf(_SC_PAGESIZE))
+    {
+        ec = std::make_error_code(std::errc::invalid_argument);
+    }
+    else
+    {
+        int prot_flags = m_flags & readonly ? PROT_READ : PROT_READ | PROT_WRITE;
+        data = map_twice(m_fd, new_size, prot_flags, address);
+        if (data == MAP_FAILED)
+            ec = {errno, std::generic_category()};
+    }
+
+    if (data == MAP_FAILED)
+    {
+        ::close(m_fd);
+        m_fd = -1;
+        m_size = 0;
+        return;
+    }
+    m_data = data;
+    m_size = new_size;
+    apply_flags();
+}
 #endif
+
+// Checks that the memory can be resized to new_size, before the file or mapping are changed
+bool cy::shared_memory::valid_size(std::error_code &ec, size_type new_size) const
+{
+#if !WIN32
+    // A ring is mapped twice, so must be a whole number of pages
+    if ((m_flags & ring) && (new_size == 0 || new_size % sysconf(_SC_PAGESIZE)))
+    {
+        ec = std::make_error_code(std::errc::invalid_argument);
+        return false;
     }
+#endif
+    return true;
+}
+
+cy::shared_memory::size_type cy::shared_memory::page_size()
+{
+#if WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwPageSize;
+#else
+    return sysconf(_SC_PAGESIZE);
+#endif
 }
 
 bool cy::shared_memory::truncate(std::error_code &ec, size_type new_size)
@@ -279,10 +755,10 @@ bool cy::shared_memory::truncate(std::error_code &ec, size_type new_size)
 
     return false;
 #else
-    if (ftruncate(m_fd, new_size))
+    if (int err = set_file_size(m_fd, get_size(), new_size, m_flags & preallocate, m_growth_chunk))
     {
         // resize failed
-        ec = {errno, std::generic_category()};
+        ec = {err, std::generic_category()};
         return true;
     }
     return false;
@@ -295,6 +771,9 @@ void cy::shared_memory::reserve(std::error_code &ec, size_type new_min)
 
     if (mapped_size < new_min)
     {
+        if (!valid_size(ec, new_min))
+            return;
+
         // Need to extend the file
         if (truncate(ec, new_min))
         {
@@ -336,6 +815,9 @@ void cy::shared_memory::unmap()
 
 void cy::shared_memory::resize(std::error_code &ec, size_type new_size)
 {
+    if (!valid_size(ec, new_size))
+        return;
+
     if (get_size() != new_size)
     {
         unmap();
@@ -368,6 +850,12 @@ void cy::shared_memory::reopen_at(std::error_code &ec, void *new_address)
 
 #else
 
+        if (m_flags & ring)
+        {
+            remap_ring(ec, m_size, new_address);
+            return;
+        }
+
 #if HAVE_MREMAP
         auto data = mremap(m_data, m_size, m_size, MREMAP_MAYMOVE | MREMAP_FIXED, new_address);
 #else
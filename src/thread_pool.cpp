@@ -0,0 +1,159 @@
+#include <cutty/thread_pool.hpp>
+
+namespace cy = cutty;
+
+// The tasks of one call to run(), which lives on the caller's stack
+struct cy::thread_pool::job
+{
+    const std::function<void(std::size_t)> *fn;
+    std::atomic<std::size_t> remaining;
+    std::exception_ptr error;
+    bool done = false;
+    std::mutex mutex;
+    std::condition_variable finished;
+};
+
+cy::thread_pool::thread_pool(unsigned threads) : m_next_queue(0), m_pending(0), m_stop(false)
+{
+    for (unsigned i = 0; i < threads; ++i)
+        m_queues.push_back(std::make_unique<queue>());
+    for (unsigned i = 0; i < threads; ++i)
+        m_threads.emplace_back([this, i] { run_worker(i); });
+}
+
+cy::thread_pool::~thread_pool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+    for (auto &t : m_threads)
+        t.join();
+}
+
+cy::thread_pool &cy::thread_pool::default_pool()
+{
+    static thread_pool pool;
+    return pool;
+}
+
+void cy::thread_pool::run(std::size_t n, const std::function<void(std::size_t)> &fn)
+{
+    if (n == 0)
+        return;
+    if (m_queues.empty() || n == 1)
+    {
+        for (std::size_t i = 0; i < n; ++i)
+            fn(i);
+        return;
+    }
+
+    job j;
+    j.fn = &fn;
+    j.remaining = n;
+
+    // Deal the tasks out to the workers, starting from a different worker each time
+    std::size_t first = m_next_queue++;
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        auto &q = *m_queues[(first + i) % m_queues.size()];
+        std::lock_guard<std::mutex> lock(q.mutex);
+        q.tasks.push_back({&j, i});
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_pending += n;
+    }
+    m_wake.notify_all();
+
+    // Help out until there is nothing left to steal
+    task t;
+    while (j.remaining && steal(m_queues.size(), t))
+        execute(t);
+
+    // Wait for tasks running on other threads
+    std::unique_lock<std::mutex> lock(j.mutex);
+    j.finished.wait(lock, [&] { return j.done; });
+
+    if (j.error)
+        std::rethrow_exception(j.error);
+}
+
+bool cy::thread_pool::pop(std::size_t q, task &t)
+{
+    {
+        auto &own = *m_queues[q];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (own.tasks.empty())
+            return false;
+        t = own.tasks.back();
+        own.tasks.pop_back();
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    --m_pending;
+    return true;
+}
+
+// Steals from the front of any queue other than q
+
+bool cy::thread_pool::steal(std::size_t q, task &t)
+{
+    for (std::size_t i = 0; i < m_queues.size(); ++i)
+    {
+        if (i == q)
+            continue;
+        auto &victim = *m_queues[i];
+        std::unique_lock<std::mutex> lock(victim.mutex);
+        if (victim.tasks.empty())
+            continue;
+        t = victim.tasks.front();
+        victim.tasks.pop_front();
+        lock.unlock();
+
+        std::lock_guard<std::mutex> pending_lock(m_mutex);
+        --m_pending;
+        return true;
+    }
+    return false;
+}
+
+void cy::thread_pool::execute(const task &t)
+{
+    auto &j = *t.owner;
+    try
+    {
+        (*j.fn)(t.index);
+    }
+    catch (...)
+    {
+        std::lock_guard<std::mutex> lock(j.mutex);
+        if (!j.error)
+            j.error = std::current_exception();
+    }
+
+    if (--j.remaining == 0)
+    {
+        std::lock_guard<std::mutex> lock(j.mutex);
+        j.done = true;
+        j.finished.notify_all();
+    }
+}
+
+void cy::thread_pool::run_worker(std::size_t q)
+{
+    for (;;)
+    {
+        task t;
+        if (pop(q, t) || steal(q, t))
+        {
+            execute(t);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_wake.wait(lock, [this] { return m_stop || m_pending; });
+        if (m_stop && !m_pending)
+            return;
+    }
+}
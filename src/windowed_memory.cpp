@@ -0,0 +1,350 @@
+#include <cutty/windowed_memory.hpp>
+
+#include <algorithm>
+#include <cassert>
+
+#if WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace cy = cutty;
+
+cy::windowed_memory::view::view() : m_owner(nullptr), m_window(nullptr), m_data(nullptr), m_size(0), m_offset(0)
+{
+}
+
+cy::windowed_memory::view::view(windowed_memory *owner, window *w, size_type offset)
+    : m_owner(owner), m_window(w), m_offset(offset)
+{
+    size_type window_offset = offset - w->index * owner->m_window_size;
+    m_data = (char *)w->data + window_offset;
+    m_size = w->size - window_offset;
+}
+
+cy::windowed_memory::view::view(view &&src)
+    : m_owner(src.m_owner), m_window(src.m_window), m_data(src.m_data), m_size(src.m_size), m_offset(src.m_offset)
+{
+    src.m_owner = nullptr;
+    src.m_window = nullptr;
+    src.m_data = nullptr;
+    src.m_size = 0;
+}
+
+cy::windowed_memory::view &cy::windowed_memory::view::operator=(view &&src)
+{
+    if (this != &src)
+    {
+        release();
+        std::swap(m_owner, src.m_owner);
+        std::swap(m_window, src.m_window);
+        std::swap(m_data, src.m_data);
+        std::swap(m_size, src.m_size);
+        m_offset = src.m_offset;
+    }
+    return *this;
+}
+
+cy::windowed_memory::view::~view()
+{
+    release();
+}
+
+void cy::windowed_memory::view::release()
+{
+    if (m_window)
+    {
+        m_owner->unpin(m_window);
+        m_owner = nullptr;
+        m_window = nullptr;
+        m_data = nullptr;
+        m_size = 0;
+    }
+}
+
+cy::windowed_memory::windowed_memory()
+    : m_size(0), m_window_size(default_window_size), m_max_windows(default_max_windows), m_flags(0), m_fd(-1)
+{
+#if WIN32
+    m_map_handle = INVALID_HANDLE_VALUE;
+    m_file_handle = INVALID_HANDLE_VALUE;
+#endif
+}
+
+cy::windowed_memory::windowed_memory(const char *filename, std::error_code &ec, int flags, size_type min_size,
+                                     size_type window_size, std::size_t max_windows)
+    : windowed_memory()
+{
+    m_max_windows = max_windows ? max_windows : 1;
+    m_flags = flags;
+
+#if WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    size_type granularity = info.dwAllocationGranularity;
+
+    int open_flags = (flags & shared_memory::trunc) ? CREATE_ALWAYS : OPEN_ALWAYS;
+    int access = (flags & shared_memory::readonly) ? GENERIC_READ : GENERIC_READ | GENERIC_WRITE;
+    int hints = (flags & shared_memory::sequential) ? FILE_FLAG_SEQUENTIAL_SCAN : FILE_FLAG_RANDOM_ACCESS;
+
+    auto hFile = CreateFile(filename, access, FILE_SHARE_WRITE | FILE_SHARE_READ, 0, open_flags,
+                            FILE_ATTRIBUTE_NORMAL | hints, 0);
+
+    if (hFile == INVALID_HANDLE_VALUE)
+    {
+        ec = {int(GetLastError()), std::system_category()};
+        return;
+    }
+    m_file_handle = hFile;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(hFile, &size))
+    {
+        ec = {int(GetLastError()), std::system_category()};
+        close();
+        return;
+    }
+    m_size = size.QuadPart;
+#else
+    size_type granularity = sysconf(_SC_PAGESIZE);
+
+    int fd_flags = 0;
+    if (flags & shared_memory::create)
+        fd_flags |= O_CREAT;
+    if (flags & shared_memory::readonly)
+        fd_flags |= O_RDONLY;
+    else
+        fd_flags |= O_RDWR;
+    if (flags & shared_memory::exclusive)
+        fd_flags |= O_EXCL;
+    if (flags & shared_memory::trunc)
+        fd_flags |= O_TRUNC;
+
+    int fd = open(filename, fd_flags, 0600);
+
+    if (fd < 0)
+    {
+        ec = {errno, std::generic_category()};
+        return;
+    }
+    m_fd = fd;
+
+    struct stat st;
+    if (fstat(fd, &st))
+    {
+        ec = {errno, std::generic_category()};
+        close();
+        return;
+    }
+    m_size = st.st_size;
+#endif
+
+    m_window_size = (window_size + granularity - 1) / granularity * granularity;
+    if (!m_window_size)
+        m_window_size = granularity;
+
+    if (m_size < min_size)
+    {
+        resize(ec, min_size);
+        if (ec)
+            close();
+    }
+}
+
+cy::windowed_memory::~windowed_memory()
+{
+    close();
+}
+
+cy::windowed_memory::operator bool() const
+{
+#if WIN32
+    return m_file_handle != INVALID_HANDLE_VALUE;
+#else
+    return m_fd >= 0;
+#endif
+}
+
+cy::windowed_memory::size_type cy::windowed_memory::size() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_size;
+}
+
+std::size_t cy::windowed_memory::mapped_windows() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_windows.size();
+}
+
+cy::windowed_memory::view cy::windowed_memory::map(std::error_code &ec, size_type offset)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (!*this || offset >= m_size)
+    {
+        ec = std::make_error_code(std::errc::invalid_argument);
+        return {};
+    }
+
+    size_type index = offset / m_window_size;
+    auto i = m_index.find(index);
+    if (i != m_index.end())
+    {
+        // Move to the front of the LRU list
+        m_windows.splice(m_windows.begin(), m_windows, i->second);
+        auto &w = m_windows.front();
+        ++w.pins;
+        return view(this, &w, offset);
+    }
+
+    evict(m_max_windows - 1);
+
+    size_type start = index * m_window_size;
+    size_type length = std::min(m_window_size, m_size - start);
+
+#if WIN32
+    if (m_map_handle == INVALID_HANDLE_VALUE)
+    {
+        int protect = (m_flags & shared_memory::readonly) ? PAGE_READONLY : PAGE_READWRITE;
+        m_map_handle = CreateFileMapping(m_file_handle, 0, protect, 0, 0, 0);
+        if (!m_map_handle)
+        {
+            m_map_handle = INVALID_HANDLE_VALUE;
+            ec = {int(GetLastError()), std::system_category()};
+            return {};
+        }
+    }
+
+    int access = (m_flags & shared_memory::readonly) ? FILE_MAP_READ : FILE_MAP_ALL_ACCESS;
+    auto data = MapViewOfFile(m_map_handle, access, DWORD(start >> 32), DWORD(start), length);
+    if (!data)
+    {
+        ec = {int(GetLastError()), std::system_category()};
+        return {};
+    }
+#else
+    int prot_flags = (m_flags & shared_memory::readonly) ? PROT_READ : PROT_READ | PROT_WRITE;
+    auto data = mmap(nullptr, length, prot_flags, MAP_SHARED, m_fd, start);
+    if (data == MAP_FAILED)
+    {
+        ec = {errno, std::generic_category()};
+        return {};
+    }
+
+    // The hints are advisory, so errors are ignored
+#if defined(MADV_HUGEPAGE)
+    if (m_flags & shared_memory::huge_pages)
+        madvise(data, length, MADV_HUGEPAGE);
+#endif
+    if (m_flags & shared_memory::sequential)
+        madvise(data, length, MADV_SEQUENTIAL);
+    else if (m_flags & shared_memory::random)
+        madvise(data, length, MADV_RANDOM);
+    if (m_flags & shared_memory::prefault)
+        madvise(data, length, MADV_WILLNEED);
+#endif
+
+    m_windows.push_front(window{index, data, length, 1});
+    m_index[index] = m_windows.begin();
+    return view(this, &m_windows.front(), offset);
+}
+
+void cy::windowed_memory::resize(std::error_code &ec, size_type new_size)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    // Windows may change size, so remap them on demand.
+    // Pinned windows are retired, and are unmapped when they are released.
+    evict(0);
+    for (auto &w : m_windows)
+        w.index = retired;
+    m_index.clear();
+
+#if WIN32
+    if (m_map_handle != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(m_map_handle);
+        m_map_handle = INVALID_HANDLE_VALUE;
+    }
+
+    LARGE_INTEGER li;
+    li.QuadPart = new_size;
+    if (!SetFilePointerEx(m_file_handle, li, nullptr, FILE_BEGIN) || !SetEndOfFile(m_file_handle))
+    {
+        ec = {int(GetLastError()), std::system_category()};
+        return;
+    }
+#else
+    if (ftruncate(m_fd, new_size))
+    {
+        ec = {errno, std::generic_category()};
+        return;
+    }
+#endif
+    m_size = new_size;
+}
+
+void cy::windowed_memory::close()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    assert(std::all_of(m_windows.begin(), m_windows.end(), [](auto &w) { return w.pins == 0; }));
+    for (auto &w : m_windows)
+        unmap(w);
+    m_windows.clear();
+    m_index.clear();
+
+#if WIN32
+    if (m_map_handle != INVALID_HANDLE_VALUE)
+        CloseHandle(m_map_handle);
+    if (m_file_handle != INVALID_HANDLE_VALUE)
+        CloseHandle(m_file_handle);
+    m_map_handle = INVALID_HANDLE_VALUE;
+    m_file_handle = INVALID_HANDLE_VALUE;
+#else
+    if (m_fd >= 0)
+        ::close(m_fd);
+    m_fd = -1;
+#endif
+    m_size = 0;
+}
+
+void cy::windowed_memory::unpin(window *w)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    --w->pins;
+    if (m_windows.size() > m_max_windows)
+        evict(m_max_windows);
+}
+
+void cy::windowed_memory::unmap(window &w)
+{
+#if WIN32
+    UnmapViewOfFile(w.data);
+#else
+    munmap(w.data, w.size);
+#endif
+}
+
+// Unmaps the least recently used windows that are not pinned,
+// until there are at most max_windows mapped.
+
+void cy::windowed_memory::evict(std::size_t max_windows)
+{
+    for (auto i = m_windows.end(); m_windows.size() > max_windows && i != m_windows.begin();)
+    {
+        --i;
+        if (i->pins == 0)
+        {
+            unmap(*i);
+            if (i->index != retired)
+                m_index.erase(i->index);
+            i = m_windows.erase(i);
+        }
+    }
+}
@@ -0,0 +1,164 @@
+#include <cutty/writeback.hpp>
+
+#include <algorithm>
+#include <iterator>
+#include <vector>
+
+namespace cy = cutty;
+
+namespace
+{
+using size_type = cy::writeback::size_type;
+
+// Adds a range to a set of disjoint ranges, merging any overlapping or adjacent ranges,
+// and returns the number of bytes newly covered
+size_type add_range(std::map<size_type, size_type> &ranges, size_type offset, size_type end)
+{
+    size_type removed = 0;
+    auto i = ranges.upper_bound(offset);
+    if (i != ranges.begin() && std::prev(i)->second >= offset)
+        --i;
+    while (i != ranges.end() && i->first <= end)
+    {
+        offset = std::min(offset, i->first);
+        end = std::max(end, i->second);
+        removed += i->second - i->first;
+        i = ranges.erase(i);
+    }
+    ranges.emplace(offset, end);
+    return end - offset - removed;
+}
+} // namespace
+
+cy::writeback::writeback(shared_memory &memory) : writeback(memory, policy())
+{
+}
+
+cy::writeback::writeback(shared_memory &memory, const policy &p) : m_memory(memory), m_policy(p)
+{
+    m_thread = std::thread([this] { run(); });
+}
+
+cy::writeback::~writeback()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_one();
+    m_thread.join();
+
+    std::error_code ec;
+    flush(ec, m_policy.sync);
+}
+
+void cy::writeback::mark_dirty(size_type offset, size_type length)
+{
+    if (!length)
+        return;
+
+    size_type end = offset + length;
+    bool notify;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_dirty.empty())
+            m_oldest = std::chrono::steady_clock::now();
+        m_dirty_bytes += add_range(m_dirty, offset, end);
+        notify = m_dirty_bytes >= m_policy.dirty_bytes;
+    }
+    if (notify)
+        m_wake.notify_one();
+}
+
+void cy::writeback::flush(std::error_code &ec, bool sync)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    // Ranges that the background thread is flushing have already left m_dirty,
+    // so a synchronous flush must wait for them to finish before it can return.
+    if (sync)
+        m_flushed.wait(lock, [this] { return m_in_flight == 0; });
+    flush_dirty(lock, sync, ec);
+}
+
+cy::writeback::size_type cy::writeback::dirty_bytes() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_dirty_bytes;
+}
+
+cy::writeback::statistics cy::writeback::stats() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+void cy::writeback::run()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_stop)
+    {
+        m_wake.wait_for(lock, m_policy.interval);
+
+        bool due = m_dirty_bytes >= m_policy.dirty_bytes ||
+                   (!m_dirty.empty() && std::chrono::steady_clock::now() - m_oldest >= m_policy.max_age);
+        if (due && !m_stop)
+        {
+            std::error_code ec;
+            flush_dirty(lock, m_policy.sync, ec);
+        }
+    }
+}
+
+// Takes the current dirty ranges and flushes them without holding the lock,
+// so that writers are not blocked by I/O.
+// A synchronous flush also re-issues ranges that earlier flushes only started writing back.
+
+void cy::writeback::flush_dirty(std::unique_lock<std::mutex> &lock, bool sync, std::error_code &ec)
+{
+    if (sync)
+    {
+        for (auto [start, end] : m_unsynced)
+            add_range(m_dirty, start, end);
+        m_unsynced.clear();
+    }
+
+    std::vector<std::pair<size_type, size_type>> ranges(m_dirty.begin(), m_dirty.end());
+    m_dirty.clear();
+    m_dirty_bytes = 0;
+    ++m_in_flight;
+
+    lock.unlock();
+
+    statistics stats;
+    for (auto [start, end] : ranges)
+    {
+        std::error_code range_ec;
+        auto t0 = std::chrono::steady_clock::now();
+        m_memory.flush(range_ec, start, end - start, sync);
+        auto latency = std::chrono::steady_clock::now() - t0;
+
+        ++stats.flushes;
+        stats.bytes += end - start;
+        stats.total_latency += latency;
+        stats.max_latency = std::max(stats.max_latency, latency);
+        if (range_ec)
+        {
+            ++stats.errors;
+            ec = range_ec;
+        }
+    }
+
+    lock.lock();
+    m_stats.flushes += stats.flushes;
+    m_stats.bytes += stats.bytes;
+    m_stats.errors += stats.errors;
+    m_stats.total_latency += stats.total_latency;
+    m_stats.max_latency = std::max(m_stats.max_latency, stats.max_latency);
+
+    if (!sync)
+        for (auto [start, end] : ranges)
+            add_range(m_unsynced, start, end);
+    --m_in_flight;
+    m_flushed.notify_all();
+}
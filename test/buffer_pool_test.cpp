@@ -0,0 +1,246 @@
+#include <cutty/buffer_pool.hpp>
+
+#include <cutty/test.hpp>
+
+#include <cstring>
+#include <filesystem>
+#include <thread>
+#include <vector>
+
+namespace cy = cutty;
+
+struct Tmpfile
+{
+    const std::filesystem::path path;
+
+    Tmpfile(std::filesystem::path p = "buffer_pool.bin") : path(p)
+    {
+        std::filesystem::remove(path);
+    }
+
+    ~Tmpfile()
+    {
+        std::filesystem::remove(path);
+    }
+};
+
+const cy::buffer_pool::size_type page = 4096;
+
+cy::buffer_pool::options small_pool(std::size_t frames)
+{
+    cy::buffer_pool::options opts;
+    opts.page_size = page;
+    opts.frames = frames;
+    opts.io_threads = 2;
+    return opts;
+}
+
+void empty_pool()
+{
+    cy::buffer_pool p;
+    cy::check(!p);
+    std::error_code ec;
+    cy::check(!p.get(ec, 0));
+    cy::check(ec);
+}
+
+void read_and_write()
+{
+    Tmpfile tmp;
+    std::error_code ec;
+    {
+        cy::buffer_pool p(tmp.path.string().c_str(), ec, cy::shared_memory::create, 20 * page + 100, small_pool(4));
+        cy::check(p);
+        cy::check(p.size() == 20 * page + 100);
+        cy::check(p.page_count() == 21);
+        cy::check_equal(p.frame_count(), 4u);
+
+        for (cy::buffer_pool::size_type i = 0; i < p.page_count(); ++i)
+        {
+            auto pg = p.get(ec, i);
+            cy::check(pg);
+            cy::check(pg.page() == i);
+            std::memset(pg.data(), int(i), pg.size());
+            pg.mark_dirty();
+        }
+
+        // The last page is partial
+        cy::check(p.get(ec, 20).size() == 100);
+
+        // Dirty pages were written back when evicted
+        auto stats = p.stats();
+        cy::check(stats.evictions >= 17);
+        cy::check(stats.writes >= 17);
+
+        // Beyond the end of the file
+        cy::check(!p.get(ec, 21));
+        cy::check(ec);
+    }
+
+    cy::check(std::filesystem::file_size(tmp.path) == 20 * page + 100);
+
+    {
+        cy::buffer_pool p(tmp.path.string().c_str(), ec, cy::shared_memory::readonly, 0, small_pool(2));
+        cy::check(p);
+        for (cy::buffer_pool::size_type i = 0; i < p.page_count(); ++i)
+        {
+            auto pg = p.get(ec, i);
+            cy::check_equal(((char *)pg.data())[pg.size() - 1], char(i));
+        }
+    }
+}
+
+void clock_eviction()
+{
+    Tmpfile tmp;
+    std::error_code ec;
+    cy::buffer_pool p(tmp.path.string().c_str(), ec, cy::shared_memory::create, 10 * page, small_pool(3));
+
+    p.get(ec, 0);
+    p.get(ec, 1);
+    p.get(ec, 2);
+
+    // Every frame has been referenced, so the sweep clears them all and evicts the first
+    p.get(ec, 3);
+    cy::check_equal(p.stats().evictions, 1u);
+
+    // Page 0 was evicted, but pages 1 and 2 are still loaded
+    auto misses = p.stats().misses;
+    p.get(ec, 1);
+    p.get(ec, 2);
+    cy::check_equal(p.stats().misses, misses);
+    p.get(ec, 0);
+    cy::check_equal(p.stats().misses, misses + 1);
+}
+
+void pinning()
+{
+    Tmpfile tmp;
+    std::error_code ec;
+    cy::buffer_pool p(tmp.path.string().c_str(), ec, cy::shared_memory::create, 10 * page, small_pool(2));
+
+    auto a = p.get(ec, 0);
+    auto b = p.get(ec, 1);
+
+    // Pinned pages are not evicted
+    cy::check(!p.get(ec, 2));
+    cy::check(ec == std::errc::no_buffer_space);
+
+    // The same frame is shared between pins
+    ec.clear();
+    auto a2 = p.get(ec, 0);
+    cy::check(a2.data() == a.data());
+
+    b.release();
+    cy::check(!b);
+    cy::check(p.get(ec, 2));
+    cy::check(!ec);
+
+    // Resizing fails while pages beyond the new end are pinned
+    auto c = p.get(ec, 5);
+    p.resize(ec, 2 * page);
+    cy::check(ec);
+}
+
+void prefetching()
+{
+    Tmpfile tmp;
+    std::error_code ec;
+    cy::buffer_pool p(tmp.path.string().c_str(), ec, cy::shared_memory::create, 8 * page, small_pool(8));
+
+    for (int i = 0; i < 8; ++i)
+        p.prefetch(i);
+
+    for (int n = 0; n < 1000 && p.stats().misses < 8; ++n)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    cy::check_equal(p.stats().misses, 8u);
+
+    for (int i = 0; i < 8; ++i)
+        p.get(ec, i);
+    cy::check_equal(p.stats().hits, 8u);
+}
+
+void concurrent_access()
+{
+    Tmpfile tmp;
+    std::error_code ec;
+    cy::buffer_pool p(tmp.path.string().c_str(), ec, cy::shared_memory::create, 32 * page, small_pool(8));
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t)
+        threads.emplace_back([&, t] {
+            for (int i = t; i < 32; i += 4)
+            {
+                std::error_code ec;
+                auto pg = p.get(ec, i);
+                std::memset(pg.data(), i, pg.size());
+                pg.mark_dirty();
+            }
+        });
+    for (auto &t : threads)
+        t.join();
+
+    for (int i = 0; i < 32; ++i)
+    {
+        auto pg = p.get(ec, i);
+        cy::check(pg);
+        cy::check_equal(((char *)pg.data())[page / 2], char(i));
+    }
+}
+
+void resize()
+{
+    Tmpfile tmp;
+    std::error_code ec;
+    cy::buffer_pool p(tmp.path.string().c_str(), ec, cy::shared_memory::create, page + 100, small_pool(4));
+
+    {
+        auto pg = p.get(ec, 1);
+        cy::check(pg.size() == 100);
+        std::memset(pg.data(), 1, pg.size());
+        pg.mark_dirty();
+    }
+
+    p.resize(ec, 3 * page);
+    cy::check(!ec);
+    cy::check(p.size() == 3 * page);
+
+    auto pg = p.get(ec, 1);
+    cy::check(pg.size() == page);
+    cy::check_equal(((char *)pg.data())[99], 1);
+    cy::check_equal(((char *)pg.data())[100], 0);
+
+    p.flush(ec);
+    cy::check(!ec);
+}
+
+void direct_io()
+{
+    Tmpfile tmp;
+    std::error_code ec;
+    auto opts = small_pool(2);
+    opts.direct = true;
+    {
+        cy::buffer_pool p(tmp.path.string().c_str(), ec, cy::shared_memory::create, 4 * page + 10, opts);
+        if (!p)
+            return; // O_DIRECT is not supported by every file system
+        for (int i = 0; i < 5; ++i)
+        {
+            auto pg = p.get(ec, i);
+            std::memset(pg.data(), i + 1, pg.size());
+            pg.mark_dirty();
+        }
+    }
+
+    // The direct write of the partial page does not extend the file
+    cy::check(std::filesystem::file_size(tmp.path) == 4 * page + 10);
+
+    cy::buffer_pool p(tmp.path.string().c_str(), ec, 0, 0, opts);
+    cy::check_equal(((char *)p.get(ec, 4).data())[9], 5);
+}
+
+int main()
+{
+    return cy::test(
+        {empty_pool, read_and_write, clock_eviction, pinning, prefetching, concurrent_access, resize, direct_io});
+}
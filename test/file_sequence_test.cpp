@@ -0,0 +1,119 @@
+#include <cutty/file_sequence.hpp>
+
+#include <cutty/test.hpp>
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+namespace cy = cutty;
+
+struct Tmpfile
+{
+    const std::filesystem::path path;
+
+    Tmpfile(const std::string &contents, std::filesystem::path p = "file_sequence.tmp") : path(p)
+    {
+        std::ofstream(path, std::ios::binary) << contents;
+    }
+
+    ~Tmpfile()
+    {
+        std::filesystem::remove(path);
+    }
+};
+
+void bytes()
+{
+    Tmpfile file("hello world");
+    auto s = cy::seq_file(file.path.string().c_str());
+    cy::check_equal(s.size(), 11u);
+    cy::check(s == cy::seq("hello world"));
+    cy::check_equal(s.count([](char c) { return c == 'o'; }), 2u);
+    cy::check(s.split_view(" ") == cy::list("hello", "world"));
+
+    // Copies share the mapping
+    auto copy = s;
+    cy::check(copy.data() == s.data());
+}
+
+void lines()
+{
+    Tmpfile file("first\nsecond\r\n\nlast");
+    auto s = cy::seq_file(file.path.string().c_str());
+    cy::check(s.lines() == cy::list("first", "second", "", "last"));
+
+    Tmpfile file2("a\nb\n", "file_sequence2.tmp");
+    cy::file_sequence s2(file2.path.string().c_str());
+    cy::check(s2.lines() == cy::list("a", "b"));
+    cy::check(s2.lines().front().data() == s2.data());
+}
+
+void records()
+{
+    struct record
+    {
+        std::uint32_t id;
+        float value;
+    };
+
+    std::string contents;
+    for (std::uint32_t i = 0; i < 100; ++i)
+    {
+        record r{i, i * 0.5f};
+        contents.append(reinterpret_cast<const char *>(&r), sizeof r);
+    }
+    contents += "xyz"; // A partial record is ignored
+
+    Tmpfile file(contents);
+    auto s = cy::seq_file(file.path.string().c_str());
+    auto rs = s.records<record>();
+    cy::check_equal(rs.size(), 100u);
+    cy::check_equal(rs.at(42).id, 42u);
+    cy::check_equal(rs.back().value, 49.5f);
+    cy::check_equal(rs.select([](const record &r) { return r.id; }).sum(), 4950u);
+}
+
+void shared_mapping()
+{
+    Tmpfile file("one\ntwo\nthree\n");
+
+    // Sequences created from a temporary file_sequence keep the file mapped
+    auto lines = cy::seq_file(file.path.string().c_str()).lines();
+    cy::check(lines == cy::list("one", "two", "three"));
+
+    auto vowels = cy::seq_file(file.path.string().c_str()).where([](char c) { return c == 'e' || c == 'o'; });
+    cy::check_equal(vowels.size(), 5u);
+
+    auto words = cy::seq_file(file.path.string().c_str()).split_view("\n").take(2);
+    cy::check(words == cy::list("one", "two"));
+
+    cy::check_equal(cy::seq_file(file.path.string().c_str()).csv().size(), 3u);
+    cy::check_equal(cy::seq_file(file.path.string().c_str()).records<char>().at(4), 't');
+}
+
+void empty_file()
+{
+    Tmpfile file("");
+    auto s = cy::seq_file(file.path.string().c_str());
+    cy::check(s.empty());
+    cy::check(s.lines().empty());
+    cy::check(s.records<int>().empty());
+}
+
+void missing_file()
+{
+    std::error_code ec;
+    auto s = cy::seq_file("does_not_exist.tmp", ec);
+    cy::check(bool(ec));
+    cy::check(s.empty());
+
+    cy::check_throws<std::system_error>([] { cy::seq_file("does_not_exist.tmp"); });
+    cy::check_throws<std::system_error>([] { cy::file_sequence s("does_not_exist.tmp"); });
+}
+
+int main()
+{
+    return cy::test({bytes, lines, records, shared_mapping, empty_file, missing_file});
+}
@@ -0,0 +1,151 @@
+#include <cutty/message_channel.hpp>
+
+#include <cutty/test.hpp>
+
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unistd.h>
+
+namespace cy = cutty;
+
+using namespace std::chrono_literals;
+
+struct Tmpfile
+{
+    const std::filesystem::path path;
+
+    Tmpfile(std::filesystem::path p = "channel.bin") : path(p)
+    {
+        std::filesystem::remove(path);
+    }
+
+    ~Tmpfile()
+    {
+        std::filesystem::remove(path);
+    }
+};
+
+std::span<const std::byte> bytes(std::string_view str)
+{
+    return std::as_bytes(std::span(str.data(), str.size()));
+}
+
+std::string_view text(std::span<const std::byte> message)
+{
+    return {(const char *)message.data(), message.size()};
+}
+
+void empty_channel()
+{
+    cy::message_channel ch;
+    cy::check(!ch);
+    cy::check(!ch.read().data());
+    cy::check(!ch.reserve(10).data());
+}
+
+void send_and_receive()
+{
+    Tmpfile tmp;
+    std::error_code ec;
+    cy::message_channel producer(tmp.path.string().c_str(), ec, 4096);
+    cy::check(producer);
+    cy::check(producer.capacity() == 4096);
+
+    cy::message_channel consumer(tmp.path.string().c_str(), ec);
+    cy::check(consumer);
+    cy::check(consumer.capacity() == 4096);
+
+    cy::check(!consumer.read().data());
+
+    auto buffer = producer.reserve(100);
+    cy::check(buffer.size() == 100);
+    std::memcpy(buffer.data(), "Hello", 5);
+    producer.commit(5);
+    cy::check(producer.try_send(bytes("")));
+    cy::check(producer.try_send(bytes("World")));
+
+    auto m = consumer.read();
+    cy::check_equal(text(m), "Hello");
+    consumer.release();
+
+    // Empty messages are not the same as no message
+    m = consumer.read();
+    cy::check(m.data());
+    cy::check_equal(m.size(), 0u);
+    consumer.release();
+
+    m = consumer.read(1s);
+    cy::check_equal(text(m), "World");
+    consumer.release();
+    cy::check(consumer.pending() == 0);
+
+    cy::check(!consumer.read(1ms).data());
+}
+
+void full_channel()
+{
+    std::error_code ec;
+    cy::message_channel ch(cy::shared_memory(ec, 4096), ec, 4096);
+    cy::check(ch);
+    cy::check(ch.max_message_size() < ch.capacity());
+    cy::check(!ch.reserve(ch.max_message_size() + 1).data());
+
+    // Messages wrap around the end of the ring
+    int sent = 0, received = 0;
+    for (int round = 0; round < 100; ++round)
+    {
+        while (ch.try_send(bytes(std::to_string(sent) + std::string(sent % 300, 'x'))))
+            ++sent;
+        cy::check(!ch.reserve(ch.max_message_size(), 1ms).data());
+
+        for (int i = 0; i < 3; ++i)
+        {
+            auto m = ch.read();
+            cy::check(m.data());
+            cy::check(text(m).starts_with(std::to_string(received)));
+            cy::check_equal(m.size(), std::to_string(received).size() + received % 300);
+            ch.release();
+            ++received;
+        }
+    }
+}
+
+void threads()
+{
+    std::error_code ec;
+    cy::shared_memory memory(ec, 4096);
+    int fd = dup(memory.fd());
+    cy::message_channel producer(std::move(memory), ec, 4096);
+    cy::message_channel consumer(cy::shared_memory(fd, ec), ec);
+    cy::check(consumer);
+
+    const int count = 100000;
+    std::thread t([&] {
+        for (int i = 0; i < count; ++i)
+        {
+            auto buffer = producer.reserve(sizeof(int) + i % 50, 10s);
+            std::memcpy(buffer.data(), &i, sizeof(int));
+            producer.commit(buffer.size());
+        }
+    });
+
+    bool ok = true;
+    for (int i = 0; i < count; ++i)
+    {
+        auto m = consumer.read(10s);
+        int value;
+        std::memcpy(&value, m.data(), sizeof(int));
+        ok = ok && value == i && m.size() == sizeof(int) + i % 50;
+        consumer.release();
+    }
+    t.join();
+    cy::check(ok);
+}
+
+int main()
+{
+    return cy::test({empty_channel, send_and_receive, full_channel, threads});
+}
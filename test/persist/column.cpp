@@ -0,0 +1,135 @@
+#include <cutty/persist/column.hpp>
+
+#include <cutty/test.hpp>
+
+#include <filesystem>
+#include <stdexcept>
+
+namespace cy = cutty;
+
+struct Root
+{
+    cy::persist::column<double, 16> values;
+
+    Root(cy::map_file &file) : values(file)
+    {
+    }
+};
+
+void empty_column()
+{
+    cy::map_file file("column.db", 0, 0, 0, 16384, 1000000, cy::create_new);
+    cy::map_data<Root> root{file, file};
+
+    cy::check(root->values.empty());
+    cy::check(root->values.size() == 0);
+    cy::check(root->values.chunk_count() == 0);
+    cy::check(root->values.values().empty());
+    cy::check(root->values.chunks().empty());
+    cy::check_throws([&] { root->values.at(0); }, "at() is out of range");
+}
+
+void append_and_scan()
+{
+    cy::map_file file("column.db", 0, 0, 0, 16384, 1000000, cy::create_new);
+    cy::map_data<Root> root{file, file};
+    auto &values = root->values;
+
+    values.push_back(0);
+    const double *first = &values[0];
+
+    for (int i = 1; i < 100; ++i)
+        values.push_back(i);
+
+    // Elements never move
+    cy::check(first == &values[0]);
+
+    cy::check_equal(values.size(), 100u);
+    cy::check_equal(values.chunk_count(), 7u);
+    cy::check_equal(values.at(37), 37);
+    cy::check_equal(values.back(), 99);
+    cy::check_equal(values.values().size(), 100u);
+    cy::check_equal(values.values().sum(), 4950);
+    cy::check(values.values() == cy::seq(0, 99).select([](int i) { return double(i); }));
+
+    // Each chunk is contiguous
+    cy::check_equal(values.chunks().size(), 7u);
+    cy::check(values.chunks().select([](const cy::pointer_sequence<double> &c) { return (int)c.size(); }) ==
+              cy::list(16, 16, 16, 16, 16, 16, 4));
+    cy::check_equal(values.chunks().aggregate(0.0, [](double t, const cy::pointer_sequence<double> &c) {
+        return t + c.sum();
+    }),
+                    4950);
+
+    // A scan only sees the elements present when it started
+    auto snapshot = values.values();
+    values.push_back(100);
+    cy::check_equal(snapshot.size(), 100u);
+    cy::check_equal(values.values().size(), 101u);
+}
+
+void reopen()
+{
+    {
+        cy::map_file file("column.db", 0, 0, 0, 16384, 1000000, cy::create_new);
+        cy::map_data<Root> root{file, file};
+        for (int i = 0; i < 1000; ++i)
+            root->values.push_back(i);
+    }
+
+    {
+        cy::map_file file("column.db", 0, 0, 0, 16384, 1000000);
+        cy::map_data<Root> root{file, file};
+        cy::check_equal(root->values.size(), 1000u);
+        cy::check_equal(root->values.values().sum(), 499500);
+    }
+}
+
+void clear()
+{
+    cy::map_file file("column.db", 0, 0, 0, 16384, 1000000, cy::create_new);
+    cy::map_data<Root> root{file, file};
+    for (int i = 0; i < 20; ++i)
+        root->values.push_back(i);
+    root->values.clear();
+    cy::check(root->values.empty());
+    root->values.push_back(1);
+    cy::check(root->values.values() == cy::list(1.0));
+}
+
+// Throws when constructed from a negative number
+struct Checked
+{
+    int value;
+
+    Checked(int v) : value(v)
+    {
+        if (v < 0)
+            throw std::invalid_argument("negative");
+    }
+};
+
+void throwing_constructor()
+{
+    cy::persist::column<Checked, 4, std::allocator<Checked>> checked;
+    for (int i = 0; i < 4; ++i)
+        checked.emplace_back(i);
+
+    // The failed element would have started a new chunk
+    cy::check_throws<std::invalid_argument>([&] { checked.emplace_back(-1); });
+    cy::check_equal(checked.size(), 4u);
+    cy::check_equal(checked.chunk_count(), 1u);
+
+    for (int i = 4; i < 10; ++i)
+        checked.emplace_back(i);
+    cy::check_equal(checked.size(), 10u);
+    for (int i = 0; i < 10; ++i)
+        cy::check_equal(checked[i].value, i);
+}
+
+int main()
+{
+    int result = cy::test({empty_column, append_and_scan, reopen, clear, throwing_constructor});
+    std::filesystem::remove("column.db");
+    return result;
+}
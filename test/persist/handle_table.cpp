@@ -0,0 +1,211 @@
+#include <cutty/persist/handle_table.hpp>
+
+#include <cutty/test.hpp>
+
+#include <atomic>
+#include <filesystem>
+#include <thread>
+#include <vector>
+
+namespace cy = cutty;
+
+struct Block
+{
+    int id;
+    char payload[124];
+};
+
+struct Root
+{
+    cy::persist::handle_table table;
+    using handle_allocator = cy::allocator<cy::persist::relocatable<Block>>;
+    std::vector<cy::persist::relocatable<Block>, handle_allocator> blocks;
+
+    Root(cy::map_file &file) : table(file), blocks(handle_allocator(file))
+    {
+    }
+};
+
+void check_block(const cy::persist::handle_table &table, cy::persist::relocatable<Block> h, int id)
+{
+    cy::persist::handle_table::pin<Block> p(table, h);
+    cy::check_equal(p->id, id);
+    cy::check_equal(p->payload[123], char(id));
+}
+
+void make_and_destroy()
+{
+    cy::map_file file("handle_table.db", 0, 0, 0, 16384, 1000000, cy::create_new);
+    cy::map_data<Root> root{file, file};
+    auto &table = root->table;
+
+    cy::check_equal(table.size(), 0u);
+    auto a = table.make<Block>(Block{1, {}});
+    auto b = table.make<Block>(Block{2, {}});
+    cy::check(a);
+    cy::check(!cy::persist::relocatable<Block>());
+    cy::check(a != b);
+    cy::check_equal(table.size(), 2u);
+    cy::check_equal(table.get(a)->id, 1);
+
+    {
+        cy::persist::handle_table::pin<Block> p(table, b);
+        cy::check_equal(p->id, 2);
+        p->id = 3;
+    }
+    cy::check_equal(table.get(b)->id, 3);
+
+    // Handles are reused
+    table.destroy(a);
+    cy::check_equal(table.size(), 1u);
+    cy::check(table.make<Block>(Block{4, {}}) == a);
+}
+
+void compact_and_trim()
+{
+    cy::map_file file("handle_table.db", 0, 0, 0, 16384, 10000000, cy::create_new);
+    cy::map_data<Root> root{file, file};
+    auto &table = root->table;
+
+    root->blocks.reserve(1000);
+    for (int i = 0; i < 1000; ++i)
+    {
+        Block b{i, {}};
+        b.payload[123] = char(i);
+        root->blocks.push_back(table.make<Block>(b));
+    }
+
+    // Free the lower part of the heap
+    for (int i = 0; i < 900; ++i)
+        table.destroy(root->blocks[i]);
+    root->blocks.erase(root->blocks.begin(), root->blocks.begin() + 900);
+
+    auto before = root->blocks.back();
+    auto old_address = table.get(before);
+
+    std::size_t moved;
+    {
+        // Pinned objects are not moved
+        cy::persist::handle_table::pin<Block> pinned(table, root->blocks.front());
+        moved = table.compact();
+        cy::check(pinned.get() == table.get(root->blocks.front()));
+    }
+    cy::check(moved > 0);
+    cy::check(table.get(before) < old_address);
+
+    for (int i = 0; i < 100; ++i)
+        check_block(table, root->blocks[i], 900 + i);
+
+    // Compaction is incremental
+    cy::check_equal(table.compact(0), 0u);
+
+    auto size = std::filesystem::file_size("handle_table.db");
+    cy::check(file.trim() > 0);
+    cy::check(std::filesystem::file_size("handle_table.db") < size);
+
+    for (int i = 0; i < 100; ++i)
+        check_block(table, root->blocks[i], 900 + i);
+
+    // The heap grows again after trimming
+    auto extra = table.make<Block>(Block{-1, {}});
+    cy::check_equal(table.get(extra)->id, -1);
+}
+
+void compact_full_heap()
+{
+    cy::map_file file("handle_table.db", 0, 0, 0, 16384, 200000, cy::create_new);
+    cy::map_data<Root> root{file, file};
+    auto &table = root->table;
+
+    root->blocks.reserve(2000);
+    try
+    {
+        for (int i = 0;; ++i)
+        {
+            Block b{i, {}};
+            b.payload[123] = char(i);
+            root->blocks.push_back(table.make<Block>(b));
+        }
+    }
+    catch (const std::bad_alloc &)
+    {
+    }
+    cy::check(root->blocks.size() > 100);
+
+    // There is nowhere to move objects to, so compaction stops without moving anything
+    cy::check_equal(table.compact(), 0u);
+
+    // Objects are not left marked as moving, so they can still be pinned
+    for (int i = 0; i < int(root->blocks.size()); ++i)
+        check_block(table, root->blocks[i], i);
+}
+
+void concurrent_destroy_and_compact()
+{
+    cy::map_file file("handle_table.db", 0, 0, 0, 16384, 10000000, cy::create_new);
+    cy::map_data<Root> root{file, file};
+    auto &table = root->table;
+
+    root->blocks.reserve(2000);
+    for (int i = 0; i < 2000; ++i)
+    {
+        Block b{i, {}};
+        b.payload[123] = char(i);
+        root->blocks.push_back(table.make<Block>(b));
+    }
+
+    // Destroy the odd blocks and reuse their slots, while another thread compacts the table
+    std::atomic<bool> done = false;
+    std::thread compactor([&] {
+        while (!done)
+            table.compact(50);
+    });
+    for (int i = 1; i < 2000; i += 2)
+    {
+        table.destroy(root->blocks[i]);
+        Block b{-i, {}};
+        b.payload[123] = char(-i);
+        root->blocks[i] = table.make<Block>(b);
+    }
+    done = true;
+    compactor.join();
+
+    cy::check_equal(table.size(), 2000u);
+    for (int i = 0; i < 2000; ++i)
+        check_block(table, root->blocks[i], i % 2 ? -i : i);
+}
+
+void reopen()
+{
+    {
+        cy::map_file file("handle_table.db", 0, 0, 0, 16384, 10000000, cy::create_new);
+        cy::map_data<Root> root{file, file};
+        for (int i = 0; i < 500; ++i)
+        {
+            Block b{i, {}};
+            b.payload[123] = char(i);
+            root->blocks.push_back(root->table.make<Block>(b));
+        }
+        for (int i = 0; i < 400; ++i)
+            root->table.destroy(root->blocks[i]);
+        root->blocks.erase(root->blocks.begin(), root->blocks.begin() + 400);
+        root->table.compact();
+        file.trim();
+    }
+
+    {
+        cy::map_file file("handle_table.db", 0, 0, 0, 16384, 10000000);
+        cy::map_data<Root> root{file, file};
+        cy::check_equal(root->table.size(), 100u);
+        for (int i = 0; i < 100; ++i)
+            check_block(root->table, root->blocks[i], 400 + i);
+    }
+}
+
+int main()
+{
+    int result =
+        cy::test({make_and_destroy, compact_and_trim, compact_full_heap, concurrent_destroy_and_compact, reopen});
+    std::filesystem::remove("handle_table.db");
+    return result;
+}
@@ -0,0 +1,218 @@
+#include <cutty/persist/roaring_bitmap.hpp>
+
+#include <cutty/test.hpp>
+
+#include <filesystem>
+#include <random>
+#include <set>
+
+namespace cy = cutty;
+
+using bitmap = cy::persist::basic_roaring_bitmap<std::allocator<char>>;
+
+void empty_bitmap()
+{
+    bitmap b;
+    cy::check(b.empty());
+    cy::check_equal(b.cardinality(), 0u);
+    cy::check(!b.contains(0));
+    cy::check(b.values().empty());
+    cy::check(!b.remove(1));
+}
+
+void add_and_remove()
+{
+    bitmap b;
+    cy::check(b.add(5));
+    cy::check(!b.add(5));
+    cy::check(b.add(1));
+    cy::check(b.add(70000));
+    cy::check(b.add(0xffffffff));
+    cy::check_equal(b.cardinality(), 4u);
+    cy::check(b.contains(70000));
+    cy::check(!b.contains(70001));
+    cy::check(b.values() == cy::list<std::uint32_t>(1u, 5u, 70000u, 0xffffffffu));
+
+    cy::check(b.remove(70000));
+    cy::check(!b.remove(70000));
+    cy::check(b.values() == cy::list<std::uint32_t>(1u, 5u, 0xffffffffu));
+}
+
+// Compare the bitmap against a std::set through every type of container
+void check_same(const bitmap &b, const std::set<std::uint32_t> &s)
+{
+    cy::check_equal(b.cardinality(), s.size());
+    cy::check(b.values() == cy::seq(s));
+    for (auto v : s)
+        cy::check(b.contains(v));
+}
+
+void containers()
+{
+    bitmap b;
+    std::set<std::uint32_t> s;
+
+    // Dense enough to become a bitmap container
+    for (std::uint32_t i = 0; i < 20000; i += 3)
+    {
+        b.add(i);
+        s.insert(i);
+    }
+    check_same(b, s);
+
+    // A long run
+    for (std::uint32_t i = 100000; i < 140000; ++i)
+    {
+        b.add(i);
+        s.insert(i);
+    }
+    check_same(b, s);
+
+    auto before = b.size_in_bytes();
+    b.optimize();
+    cy::check(b.size_in_bytes() < before);
+    check_same(b, s);
+
+    // Update a run container
+    b.add(99999);
+    s.insert(99999);
+    b.remove(120000);
+    s.erase(120000);
+    check_same(b, s);
+
+    // Shrink a bitmap back to an array
+    for (std::uint32_t i = 0; i < 20000; i += 3)
+    {
+        if (i % 6)
+        {
+            b.remove(i);
+            s.erase(i);
+        }
+    }
+    check_same(b, s);
+}
+
+void set_algebra()
+{
+    std::mt19937 gen(42);
+    for (std::uint32_t range : {1000u, 100000u, 3000000u})
+    {
+        bitmap a, b;
+        std::set<std::uint32_t> sa, sb;
+        for (int i = 0; i < 50000; ++i)
+        {
+            auto x = gen() % range, y = gen() % range;
+            a.add(x);
+            sa.insert(x);
+            b.add(y);
+            sb.insert(y);
+        }
+        for (std::uint32_t i = range / 2; i < range / 2 + 5000; ++i)
+        {
+            a.add(i);
+            sa.insert(i);
+        }
+        a.optimize();
+
+        std::set<std::uint32_t> si, su;
+        std::set_intersection(sa.begin(), sa.end(), sb.begin(), sb.end(), std::inserter(si, si.end()));
+        std::set_union(sa.begin(), sa.end(), sb.begin(), sb.end(), std::inserter(su, su.end()));
+
+        check_same(a & b, si);
+        check_same(a | b, su);
+        cy::check_equal(a.intersection_cardinality(b), si.size());
+        cy::check_equal(b.intersection_cardinality(a), si.size());
+        cy::check(a == a);
+        cy::check(!(a == b));
+
+        auto c = a;
+        c &= b;
+        cy::check(c == (a & b));
+        c |= a;
+        cy::check(c == a);
+    }
+}
+
+// Counts allocations, to check that queries do not allocate in the bitmap's heap
+int allocations = 0;
+
+template <typename T> struct counting_allocator : std::allocator<T>
+{
+    counting_allocator() = default;
+
+    template <typename U> counting_allocator(const counting_allocator<U> &)
+    {
+    }
+
+    T *allocate(std::size_t n)
+    {
+        ++allocations;
+        return std::allocator<T>::allocate(n);
+    }
+};
+
+void queries_do_not_allocate()
+{
+    cy::persist::basic_roaring_bitmap<counting_allocator<char>> a, b;
+    for (std::uint32_t i = 0; i < 100000; ++i)
+    {
+        a.add(i);
+        if (i % 3 == 0)
+            b.add(i);
+    }
+    a.optimize();
+
+    allocations = 0;
+    cy::check_equal(a.intersection_cardinality(b), 33334u);
+    cy::check(a == a);
+    cy::check(!(a == b));
+    cy::check_equal(allocations, 0);
+}
+
+void memory_usage()
+{
+    bitmap b;
+    const int n = 1000000;
+    for (std::uint32_t i = 0; i < n; ++i)
+        b.add(i * 7);
+
+    // std::set<int> uses around 40 bytes per element
+    cy::check(b.size_in_bytes() * 10 < n * 40);
+}
+
+struct Root
+{
+    cy::persist::roaring_bitmap ids;
+
+    Root(cy::map_file &file) : ids(file)
+    {
+    }
+};
+
+void persistent()
+{
+    {
+        cy::map_file file("roaring.db", 0, 0, 0, 16384, 10000000, cy::create_new);
+        cy::map_data<Root> root{file, file};
+        for (std::uint32_t i = 0; i < 100000; i += 2)
+            root->ids.add(i);
+        root->ids.optimize();
+    }
+
+    {
+        cy::map_file file("roaring.db", 0, 0, 0, 16384, 10000000);
+        cy::map_data<Root> root{file, file};
+        cy::check_equal(root->ids.cardinality(), 50000u);
+        cy::check(root->ids.contains(99998));
+        cy::check(!root->ids.contains(99999));
+        cy::check(root->ids.values().take(3) == cy::list<std::uint32_t>(0u, 2u, 4u));
+    }
+}
+
+int main()
+{
+    int result = cy::test({empty_bitmap, add_and_remove, containers, set_algebra, queries_do_not_allocate, memory_usage,
+                           persistent});
+    std::filesystem::remove("roaring.db");
+    return result;
+}
@@ -0,0 +1,131 @@
+#include <cutty/persist/sharded_map_file.hpp>
+
+#include <cutty/test.hpp>
+
+#include <filesystem>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace cy = cutty;
+
+const int segments = 4;
+
+struct Root
+{
+    int *blocks[segments];
+    std::vector<int, cy::persist::sharded_allocator<int>> numbers;
+
+    Root(cy::persist::sharded_map_file &heap) : blocks{}, numbers(heap)
+    {
+    }
+};
+
+auto names()
+{
+    return cy::persist::sharded_map_file::segment_names("sharded.db", segments);
+}
+
+void remove_files()
+{
+    for (auto &name : names())
+        std::filesystem::remove(name);
+}
+
+void open_heap()
+{
+    cy::persist::sharded_map_file heap(names(), 0, 0, 0, 16384, 1000000, cy::create_new);
+    cy::check(heap);
+    cy::check_equal(heap.segment_count(), std::size_t(segments));
+    cy::check(heap.empty());
+    for (auto &name : names())
+        cy::check(std::filesystem::exists(name));
+
+    cy::persist::sharded_map_file empty;
+    cy::check(!empty);
+
+    // Allocators are only equal if they use the same heap
+    cy::persist::sharded_allocator<int> a(heap), b(heap), c(empty);
+    cy::check(a == b);
+    cy::check(a == cy::persist::sharded_allocator<char>(heap));
+    cy::check(a != c);
+    static_assert(!std::allocator_traits<cy::persist::sharded_allocator<int>>::is_always_equal::value);
+
+    cy::check_throws<std::invalid_argument>([] {
+        cy::persist::sharded_map_file heap(names(), 0, 0, 0, 16384, 1 << 20, cy::create_new, 0x188000000000ll, 1 << 16);
+    });
+}
+
+void parallel_allocation()
+{
+    {
+        cy::persist::sharded_map_file heap(names(), 0, 0, 0, 16384, 1000000, cy::create_new);
+        cy::map_data<Root> root{heap.root_segment(), heap};
+
+        std::vector<std::thread> threads;
+        for (int t = 0; t < segments; ++t)
+        {
+            threads.emplace_back([&, t] {
+                cy::persist::sharded_map_file::thread_domain(t);
+                cy::check(&heap.local_segment() == &heap.segment(t));
+
+                int *block = nullptr;
+                for (int i = 0; i < 100; ++i)
+                {
+                    // Churn the allocator in this thread's segment
+                    if (block)
+                        heap.free(block, 1000 * sizeof(int));
+                    block = (int *)heap.malloc(1000 * sizeof(int));
+                    cy::check(block);
+                }
+                for (int i = 0; i < 1000; ++i)
+                    block[i] = t * 1000 + i;
+                root->blocks[t] = block;
+            });
+        }
+        for (auto &t : threads)
+            t.join();
+
+        for (int t = 0; t < segments; ++t)
+            cy::check_equal(heap.segment_of(root->blocks[t]), t);
+        cy::check_equal(heap.segment_of(&root), -1);
+
+        cy::persist::sharded_map_file::thread_domain(2);
+        for (int i = 0; i < 100; ++i)
+            root->numbers.push_back(i);
+        cy::check_equal(heap.segment_of(root->numbers.data()), 2);
+    }
+
+    {
+        cy::persist::sharded_map_file heap(names(), 0, 0, 0, 16384, 1000000);
+        cy::check(!heap.empty());
+        cy::map_data<Root> root{heap.root_segment(), heap};
+        for (int t = 0; t < segments; ++t)
+        {
+            cy::check_equal(heap.segment_of(root->blocks[t]), t);
+            for (int i = 0; i < 1000; ++i)
+                cy::check_equal(root->blocks[t][i], t * 1000 + i);
+        }
+        cy::check_equal(root->numbers.size(), 100u);
+        cy::check_equal(root->numbers[99], 99);
+    }
+}
+
+void explicit_domain()
+{
+    cy::persist::sharded_map_file heap(names(), 0, 0, 0, 16384, 1000000, cy::create_new);
+    auto capacity = heap.capacity();
+    for (unsigned d = 0; d < 8; ++d)
+    {
+        auto p = heap.malloc(d, 64);
+        cy::check_equal(heap.segment_of(p), int(d % segments));
+    }
+    cy::check(heap.capacity() < capacity);
+}
+
+int main()
+{
+    int result = cy::test({open_heap, parallel_allocation, explicit_domain});
+    remove_files();
+    return result;
+}
@@ -0,0 +1,105 @@
+#include <cutty/persist/string_pool.hpp>
+
+#include <cutty/test.hpp>
+
+#include <filesystem>
+#include <string>
+#include <unordered_set>
+
+namespace cy = cutty;
+
+struct Root
+{
+    cy::persist::string_pool tags;
+    cy::persist::string_handle red;
+
+    Root(cy::map_file &file) : tags(file)
+    {
+    }
+};
+
+void empty_pool()
+{
+    cy::map_file file("string_pool.db", 0, 0, 0, 16384, 1000000, cy::create_new);
+    cy::map_data<Root> root{file, file};
+
+    cy::check_equal(root->tags.size(), 0u);
+    cy::check(!root->tags.find("red"));
+    cy::check(!cy::persist::string_handle());
+}
+
+void intern()
+{
+    cy::map_file file("string_pool.db", 0, 0, 0, 16384, 1000000, cy::create_new);
+    cy::map_data<Root> root{file, file};
+    auto &tags = root->tags;
+
+    auto red = tags.intern("red");
+    auto green = tags.intern("green");
+    cy::check(red);
+    cy::check(red != green);
+    cy::check(red == tags.intern(std::string("red")));
+    cy::check(red == tags.find("red"));
+    cy::check(!tags.find("blue"));
+    cy::check_equal(tags.size(), 2u);
+
+    cy::check(tags.get(red) == "red");
+    cy::check(tags[green] == "green");
+    cy::check_equal(std::string(tags.c_str(green)), "green");
+
+    // The empty string is a string like any other
+    auto empty = tags.intern("");
+    cy::check(empty);
+    cy::check(tags.get(empty).empty());
+
+    std::unordered_set<cy::persist::string_handle> set{red, green, tags.intern("red")};
+    cy::check_equal(set.size(), 2u);
+}
+
+void many_strings()
+{
+    cy::map_file file("string_pool.db", 0, 0, 0, 16384, 10000000, cy::create_new);
+    cy::map_data<Root> root{file, file};
+    auto &tags = root->tags;
+
+    std::vector<cy::persist::string_handle> handles;
+    for (int i = 0; i < 10000; ++i)
+        handles.push_back(tags.intern("tag" + std::to_string(i % 2500)));
+
+    cy::check_equal(tags.size(), 2500u);
+    for (int i = 0; i < 10000; ++i)
+    {
+        cy::check(handles[i] == handles[i % 2500]);
+        cy::check(tags.get(handles[i]) == "tag" + std::to_string(i % 2500));
+    }
+}
+
+void reopen()
+{
+    std::uint32_t red;
+    {
+        cy::map_file file("string_pool.db", 0, 0, 0, 16384, 1000000, cy::create_new);
+        cy::map_data<Root> root{file, file};
+        root->red = root->tags.intern("red");
+        red = root->red.id();
+        for (int i = 0; i < 100; ++i)
+            root->tags.intern(std::to_string(i));
+    }
+
+    {
+        cy::map_file file("string_pool.db", 0, 0, 0, 16384, 1000000);
+        cy::map_data<Root> root{file, file};
+        cy::check_equal(root->red.id(), red);
+        cy::check(root->tags.get(root->red) == "red");
+        cy::check(root->tags.find("red") == root->red);
+        cy::check(root->tags.find("99"));
+        cy::check_equal(root->tags.size(), 101u);
+    }
+}
+
+int main()
+{
+    int result = cy::test({empty_pool, intern, many_strings, reopen});
+    std::filesystem::remove("string_pool.db");
+    return result;
+}
@@ -0,0 +1,100 @@
+#include <cutty/published.hpp>
+
+#include <cutty/test.hpp>
+
+#include <atomic>
+#include <filesystem>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace cy = cutty;
+
+struct Tmpfile
+{
+    const std::filesystem::path path;
+
+    Tmpfile(std::filesystem::path p = "published.bin") : path(p)
+    {
+        std::filesystem::remove(path);
+    }
+
+    ~Tmpfile()
+    {
+        std::filesystem::remove(path);
+    }
+};
+
+// A value whose fields must always be consistent
+struct Quote
+{
+    long bid, ask, spread;
+    char padding[200] = {};
+};
+
+void publish_and_read()
+{
+    Tmpfile tmp;
+    std::error_code ec;
+    cy::published<Quote> writer(tmp.path.string().c_str(), ec);
+    cy::check(writer);
+    cy::check_equal(writer.version(), 0u);
+    cy::check_equal(writer.read().bid, 0);
+
+    writer.publish({100, 101, 1});
+    cy::check_equal(writer.version(), 1u);
+
+    cy::published<Quote> reader(tmp.path.string().c_str(), ec);
+    cy::check(reader);
+    cy::check_equal(reader.version(), 1u);
+    cy::check_equal(reader.read().ask, 101);
+
+    writer.update([](Quote &q) {
+        q.ask = 105;
+        q.spread = q.ask - q.bid;
+    });
+    Quote q;
+    cy::check(reader.try_read(q));
+    cy::check_equal(q.spread, 5);
+    cy::check_equal(reader.version(), 2u);
+}
+
+void concurrent_readers()
+{
+    std::error_code ec;
+    cy::shared_memory memory(ec, 4096);
+    int fd = dup(memory.fd());
+    cy::published<Quote> writer(std::move(memory), ec);
+
+    std::atomic<bool> done = false;
+    std::atomic<int> torn = 0;
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 4; ++i)
+    {
+        readers.emplace_back([&] {
+            std::error_code ec;
+            cy::published<Quote> reader(cy::shared_memory(dup(fd), ec), ec);
+            while (!done)
+            {
+                auto q = reader.read();
+                if (q.ask - q.bid != q.spread)
+                    ++torn;
+            }
+        });
+    }
+
+    for (long i = 0; i < 200000; ++i)
+        writer.publish({i, 2 * i, i});
+    done = true;
+    for (auto &t : readers)
+        t.join();
+    ::close(fd);
+
+    cy::check_equal(torn.load(), 0);
+    cy::check_equal(writer.version(), 200000u);
+}
+
+int main()
+{
+    return cy::test({publish_and_read, concurrent_readers});
+}
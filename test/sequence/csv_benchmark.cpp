@@ -0,0 +1,77 @@
+// Compares reading CSV with csv() against the approach in samples/sequence/csvreader.cpp.
+// Usage: sequence_csv_benchmark [rows]
+
+#include <cutty/file_sequence.hpp>
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+namespace cy = cutty;
+
+const char *filename = "csv_benchmark.csv";
+
+// As in csvreader.cpp
+std::string trim(const std::string &str)
+{
+    const char *WS = " \t";
+    auto i = str.find_first_not_of(WS);
+    if (i == std::string::npos)
+        return "";
+    auto j = str.find_last_not_of(WS);
+    return str.substr(i, j - i + 1);
+}
+
+template <typename Fn> void time(const char *name, Fn fn)
+{
+    auto start = std::chrono::steady_clock::now();
+    auto result = fn();
+    std::chrono::duration<double, std::milli> duration = std::chrono::steady_clock::now() - start;
+    std::cout << name << ": " << duration.count() << "ms (" << result << ")\n";
+}
+
+int main(int argc, char **argv)
+{
+    int rows = argc > 1 ? std::stoi(argv[1]) : 200000;
+    {
+        std::ofstream file(filename, std::ios::binary);
+        file << "id,name,price,quantity\r\n";
+        for (int i = 0; i < rows; ++i)
+            file << i << ",item " << i << "," << i * 0.25 << "," << i % 100 << "\r\n";
+    }
+    std::cout << "Reading " << rows << " rows, " << std::filesystem::file_size(filename) << " bytes\n";
+
+    time("csvreader.cpp, cells", [] {
+        std::ifstream file(filename);
+        std::size_t cells = 0;
+        for (auto &line : cy::seq(file).split("\r\n"))
+            for (auto &cell : cy::seq(line).split(",").select(trim))
+                cells += !cell.empty();
+        return cells;
+    });
+
+    time("csv(), cells", [] {
+        auto file = cy::seq_file(filename);
+        std::size_t cells = 0;
+        for (auto &row : file.csv())
+            cells += row.size();
+        return cells;
+    });
+
+    time("csvreader.cpp, sum of quantity", [] {
+        std::ifstream file(filename);
+        long total = 0;
+        for (auto &line : cy::seq(file).split("\r\n").skip(1))
+            total += std::stol(cy::seq(line).split(",").at(3));
+        return total;
+    });
+
+    time("csv(), sum of quantity", [] {
+        auto file = cy::seq_file(filename);
+        return file.csv().skip(1).accumulate(0L, [](long &total, auto &row) { total += row.template get<long>(3); });
+    });
+
+    std::filesystem::remove(filename);
+}
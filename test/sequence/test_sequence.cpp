@@ -8,10 +8,13 @@
 
 #include <cutty/check.hpp>
 
+#include <cmath>
 #include <fstream>
 #include <future>
 #include <iostream>
+#include <list>
 #include <map>
+#include <set>
 #include <sstream>
 #include <vector>
 
@@ -316,6 +319,11 @@ void test_primes()
 
     cy::check(primes.take(5) == cy::list(2, 3, 5, 7, 11));
 
+    auto cached = primes.cache();
+    cy::check(cached.size() == 168);
+    cy::check(cached.back() == 997);
+    cy::check(cached == primes);
+
     std::vector<int> primes2;
     for (int n = 2; n <= 1000; ++n)
     {
@@ -424,6 +432,554 @@ void test_accumulate()
     cy::check(cy::list(3, 4, 5).accumulate(std::string(), [](std::string &str, int n) { str += 'x'; }) == "xxx");
 }
 
+void test_iterate()
+{
+    // Collects the elements of a sequence using internal iteration, stopping after 'limit' elements
+    auto collect = [](const auto &s, std::size_t limit = 100) {
+        std::vector<int> result;
+        bool completed = s.iterate([&](int x) {
+            result.push_back(x);
+            return result.size() < limit;
+        });
+        cy::check(completed == (result.size() < limit));
+        return result;
+    };
+
+    auto expected = [](auto s) { return s.template make<std::vector<int>>(); };
+
+    auto s = cy::seq(1, 10);
+    cy::check(collect(s) == expected(s));
+    cy::check(collect(s, 3) == std::vector<int>{1, 2, 3});
+
+    auto where = s.where([](int x) { return x % 2 == 0; });
+    cy::check(collect(where) == expected(where));
+
+    auto select = s.select([](int x) { return x * x; });
+    cy::check(collect(select) == expected(select));
+    cy::check(collect(select, 2) == std::vector<int>{1, 4});
+
+    cy::check(collect(s.take(3)) == std::vector<int>{1, 2, 3});
+    cy::check(collect(s.take(3), 3) == std::vector<int>{1, 2, 3});
+    cy::check(collect(s.take(0)).empty());
+    cy::check(collect(s.skip(7)) == std::vector<int>{8, 9, 10});
+    cy::check(collect(s.skip(20)).empty());
+
+    auto take_while = cy::list(1, 2, 3, 4, 1).take_while([](int x) { return x > 1; });
+    cy::check(collect(take_while) == expected(take_while));
+
+    auto skip_until = cy::list(1, 2, 3, 1).skip_until([](int x) { return x > 1; });
+    cy::check(collect(skip_until) == expected(skip_until));
+
+    auto concat = cy::list(1, 2) + cy::list(3, 4);
+    cy::check(collect(concat) == std::vector<int>{1, 2, 3, 4});
+    cy::check(collect(concat, 1) == std::vector<int>{1});
+
+    cy::check(collect(cy::list(1, 2).repeat(3)) == std::vector<int>{1, 2, 1, 2, 1, 2});
+    cy::check(collect(cy::single(5)) == std::vector<int>{5});
+    cy::check(collect(cy::seq<int>()).empty());
+
+    std::vector<int> v{4, 5, 6};
+    cy::check(collect(cy::seq(v)) == v);
+    cy::check(collect(cy::stored_seq(std::vector<int>{4, 5, 6})) == v);
+
+    // Virtual sequences fall back to first()/next()
+    const cy::sequence<int> &vs = where;
+    cy::check(collect(vs) == expected(where));
+
+    // The fused pipeline gives the same results as external iteration
+    auto pipeline = cy::seq(0, 1000).where([](int n) { return n % 2 == 0; }).select([](int n) { return n * n; });
+    int sum = 0;
+    for (auto x : pipeline)
+        sum += x;
+    cy::check(pipeline.sum() == sum);
+    cy::check(pipeline.size() == 501);
+    cy::check(pipeline.count([](int n) { return n > 1000; }) == 485);
+    cy::check(pipeline.any([](int n) { return n == 16; }));
+    cy::check(!pipeline.any([](int n) { return n == 15; }));
+}
+
+int sumEvenSquares(const cy::sequence<int> &items)
+{
+    return items.where([](int n) { return n % 2 == 0; }).select([](int n) { return n * n; }).sum();
+}
+
+void test_batches()
+{
+    // Batches are filled by the underlying pipeline
+    auto s = cy::seq(1, 1000);
+    const cy::sequence<int> &vs = s;
+    std::array<int, 300> buffer;
+    cy::check(vs.self().first_batch(buffer) == 300);
+    cy::check(buffer[0] == 1 && buffer[299] == 300);
+    cy::check(vs.self().next_batch(buffer) == 300);
+    cy::check(buffer[0] == 301);
+    cy::check(vs.self().next_batch(buffer) == 300);
+    cy::check(vs.self().next_batch(buffer) == 100);
+    cy::check(buffer[99] == 1000);
+
+    // Internal iteration over virtual sequences, spanning several batches
+    int sum = 0;
+    for (int n = 0; n <= 1000; n += 2)
+        sum += n * n;
+    cy::check(sumEvenSquares(cy::seq(0, 1000)) == sum);
+    cy::check(vs.self().size() == 1000);
+    cy::check(vs.count([](int n) { return n > 500; }) == 500);
+    cy::check(vs.any([](int n) { return n == 999; }));
+    cy::check(!vs.any([](int n) { return n == 1001; }));
+
+    std::vector<int> v;
+    vs.take(600).write_to(v);
+    cy::check(v.size() == 600 && v.back() == 600);
+
+    // An exact multiple of the batch size
+    cy::check(sumEvenSquares(cy::seq(1, int(2 * cy::sequence<int>::batch_size))) ==
+              cy::seq(1, int(2 * cy::sequence<int>::batch_size)).where([](int n) { return n % 2 == 0; }).select([](int n) { return n * n; }).sum());
+    cy::check(sumEvenSquares(cy::seq<int>()) == 0);
+
+    auto concat = [](const std::string &a, const std::string &b) { return a + b; };
+    const cy::sequence<std::string> &strings = cy::list(std::string("a"), std::string("b"));
+    cy::check(strings.aggregate(std::string(), concat) == "ab");
+
+    // Batches start small so that stopping early does not evaluate many extra elements
+    int evaluated = 0;
+    auto counted = cy::seq(1, 1000).select([&](int n) { ++evaluated; return n; });
+    const cy::sequence<int> &cs = counted;
+    cy::check(cs.any([](int n) { return n == 1; }));
+    cy::check(evaluated == 1);
+    evaluated = 0;
+    cy::check(cs.any([](int n) { return n == 10; }));
+    cy::check(evaluated <= 20);
+    evaluated = 0;
+    cy::check(cs.sum() == 500500);
+    cy::check(evaluated == 1000);
+
+    // Elements too large to batch use first()/next()
+    std::vector<std::array<char, 100>> large(3);
+    const cy::sequence<std::array<char, 100>> &ls = cy::seq(large);
+    cy::check(ls.count([](auto &a) { return a[0] == 0; }) == 3);
+}
+
+void test_kernels()
+{
+    std::vector<int> ints(1000);
+    for (int i = 0; i < 1000; ++i)
+        ints[i] = (i * 37) % 1001 - 500;
+    auto s = cy::seq(ints);
+
+    // Contiguous sequences give the same results as the generic implementation
+    auto generic = s.where([](int) { return true; });
+    cy::check(s.sum() == generic.sum());
+    cy::check(s.min() == generic.min());
+    cy::check(s.max() == generic.max());
+    cy::check(s.dot(s) == generic.dot(generic));
+    cy::check(s == generic);
+    cy::check(s.dot(cy::seq(ints).take(10)) == generic.take(10).dot(generic));
+
+    // Sequences of different lengths
+    cy::check(s.dot(cy::seq(ints.data(), 3)) == s.take(3).dot(s));
+    cy::check(s != cy::seq(ints.data(), 999));
+
+    std::vector<int> other = ints;
+    cy::check(s == cy::seq(other));
+    other[999] = 0;
+    cy::check(s != cy::seq(other));
+
+    // Small sizes, including the remainders after each block
+    for (int n = 0; n < 40; ++n)
+    {
+        auto t = cy::seq(ints.data(), n);
+        cy::check(t.sum() == t.aggregate(0, [](int a, int b) { return a + b; }));
+        if (n)
+            cy::check(t.max() == t.take(n).max());
+    }
+
+    cy::check(cy::list(3, 1, 2).min() == 1);
+    cy::check(cy::list(3, 1, 2).max() == 3);
+    cy::check(cy::list(1.5, 2.5).sum() == 4.0);
+    cy::check(cy::list(1, 2, 3).dot(cy::list(4, 5, 6)) == 32);
+    cy::check(cy::stored_seq(std::vector<unsigned>{4, 5}).dot(cy::list(2u, 3u)) == 23);
+
+    cy::check_throws<std::out_of_range>([] { cy::seq<int>().min(); });
+    cy::check_throws<std::out_of_range>([] { cy::seq(static_cast<const int *>(nullptr), 0).max(); });
+
+    // Pairwise summation of floating point numbers is more accurate than adding in turn
+    std::vector<float> floats(1 << 20, 0.1f);
+    float naive = 0;
+    for (auto f : floats)
+        naive += f;
+    double exact = 0.1f * double(floats.size());
+    float pairwise = cy::seq(floats).sum();
+    cy::check(std::abs(pairwise - exact) < std::abs(naive - exact));
+    cy::check(std::abs(pairwise - exact) / exact < 1e-5);
+
+    std::vector<double> doubles{1, -2, 3.5};
+    cy::check(cy::seq(doubles).min() == -2);
+    cy::check(cy::seq(doubles).max() == 3.5);
+    cy::check(cy::seq(doubles).dot(cy::seq(doubles)) == 1 + 4 + 12.25);
+}
+
+void test_random_access()
+{
+    std::vector<int> v{1, 2, 3, 4, 5};
+    auto square = [](int x) { return x * x; };
+
+    static_assert(cy::sequences::helpers::random_access_sequence<decltype(cy::seq(v))>);
+    static_assert(cy::sequences::helpers::random_access_sequence<decltype(cy::seq(1, 10))>);
+    static_assert(cy::sequences::helpers::random_access_sequence<decltype(cy::list(1, 2))>);
+    static_assert(cy::sequences::helpers::random_access_sequence<decltype(cy::seq(v).select(square).skip(1).take(2))>);
+    static_assert(cy::sequences::helpers::random_access_sequence<decltype(cy::seq(v) + cy::seq(1, 3))>);
+    static_assert(!cy::sequences::helpers::random_access_sequence<decltype(cy::seq(v).where(square))>);
+    static_assert(!cy::sequences::helpers::random_access_sequence<decltype(cy::seq(v).where(square).skip(1))>);
+
+    auto s = cy::seq(v);
+    cy::check(s.at(2) == 3);
+    cy::check(s.back() == 5);
+    cy::check(s.at_or_default(5, 0) == 0);
+    cy::check_throws<std::out_of_range>([&] { s.at(5); });
+    cy::check_throws<std::out_of_range>([] { cy::seq<int>().back(); });
+    cy::check(cy::seq(1, 10).at(3) == 4);
+    cy::check(cy::seq(1, 10).back() == 10);
+    cy::check(cy::seq(1, 10).skip(3).take(2).back() == 5);
+
+    auto selected = s.select(square);
+    cy::check(selected.size() == 5);
+    cy::check(selected.at(3) == 16);
+    cy::check(selected.back_or_default(0) == 25);
+
+    cy::check(s.take(3).size() == 3);
+    cy::check(s.take(10).size() == 5);
+    cy::check(s.take(-1).size() == 0);
+    cy::check(s.skip(2).size() == 3);
+    cy::check(s.skip(10).size() == 0);
+    cy::check(s.skip(-1).size() == 5);
+    cy::check(s.skip(2).at(0) == 3);
+    cy::check(s.skip(10).empty());
+    cy::check(s.skip(2) == cy::list(3, 4, 5));
+    cy::check(s.skip(2).sum() == 12);
+
+    auto concat = s + cy::seq(10, 12);
+    cy::check(concat.size() == 8);
+    cy::check(concat.at(4) == 5);
+    cy::check(concat.at(5) == 10);
+    cy::check(concat.back() == 12);
+
+    auto merged = s.merge(cy::seq(10, 12), [](int a, int b) { return a + b; });
+    cy::check(merged.size() == 3);
+    cy::check(merged.back() == 15);
+
+    auto repeated = cy::list(1, 2).repeat(3);
+    cy::check(repeated.size() == 6);
+    cy::check(repeated.at(3) == 2);
+    cy::check(cy::list(1, 2).repeat(0).size() == 0);
+
+    // Skipping does not evaluate the skipped elements
+    int calls = 0;
+    auto counted = cy::seq(1, 1000000).select([&](int x) {
+        ++calls;
+        return x;
+    });
+    cy::check(counted.skip(999990).take(5).sum() == 999991 + 999992 + 999993 + 999994 + 999995);
+    cy::check(counted.skip(999990).front() == 999991);
+    cy::check(counted.back() == 1000000);
+    cy::check(calls == 7);
+
+    // Sequences without random access still work
+    auto evens = s.where([](int x) { return x % 2 == 0; });
+    cy::check(evens.skip(1).size() == 1);
+    cy::check(evens.back() == 4);
+    cy::check(evens.skip(1).take(1).size() == 1);
+}
+
+void test_parallel()
+{
+    std::vector<int> v(100000);
+    for (int i = 0; i < int(v.size()); ++i)
+        v[i] = i % 1000;
+    auto even = [](int x) { return x % 2 == 0; };
+    auto twice = [](int x) { return long(x) * 2; };
+
+    cy::thread_pool pool(4);
+    auto serial = cy::seq(v).where(even).select(twice);
+    auto parallel = serial.parallel(pool);
+    cy::check(parallel.sum() == serial.sum());
+    cy::check(parallel.size() == serial.size());
+    cy::check(parallel.count([](long x) { return x > 1000; }) == serial.count([](long x) { return x > 1000; }));
+    cy::check(parallel.any([](long x) { return x == 1996; }));
+    cy::check(!parallel.any([](long x) { return x == 1; }));
+    cy::check(parallel.aggregate(0L, [](long a, long b) { return std::max(a, b); },
+                                 [](long a, long b) { return std::max(a, b); }) == 1996);
+
+    // Integer ranges and stored containers are splittable, and the default pool is used
+    cy::check(cy::seq(1, 1000000).select([](int x) { return long(x); }).parallel().sum() == 500000500000L);
+    cy::check(cy::stored_seq(std::vector<int>(v)).parallel().size() == v.size());
+
+    // Small and empty sources run as a single slice
+    cy::check(cy::list(1, 2, 3).parallel(pool).sum() == 6);
+    cy::check(cy::seq<int>().parallel(pool).sum() == 0);
+    cy::check(cy::seq<int>().parallel(pool).size() == 0);
+}
+
+void test_cache()
+{
+    int calls = 0;
+    auto squares = cy::seq(1, 10)
+                       .select([&](int x) {
+                           ++calls;
+                           return x * x;
+                       })
+                       .cache();
+
+    // The source is evaluated once, even across several passes
+    cy::check(squares.any());
+    cy::check(!squares.cached());
+    cy::check(squares.size() == 10);
+    cy::check(squares.cached());
+    cy::check(squares.sum() == 385);
+    cy::check(squares == cy::list(1, 4, 9, 16, 25, 36, 49, 64, 81, 100));
+    cy::check(calls == 10);
+
+    // Copies and adaptors share the cache
+    auto evens = squares.where([](int x) { return x % 2 == 0; });
+    cy::check(evens.size() == 5);
+    cy::check(calls == 10);
+
+    // Interleaved passes over copies read each element once
+    calls = 0;
+    auto cubes = cy::seq(1, 5)
+                     .select([&](int x) {
+                         ++calls;
+                         return x * x * x;
+                     })
+                     .cache();
+    auto copy = cubes;
+    auto a = cubes.begin(), b = copy.begin();
+    cy::check(*a == 1 && *++a == 8 && *++a == 27);
+    cy::check(*b == 1 && *++b == 8);
+    cy::check(cubes.take(2).sum() == 9);
+    cy::check(*++b == 27 && *++b == 64);
+    cy::check(cubes.size() == 5);
+    cy::check(calls == 5);
+
+    // When the limit is exceeded, the elements are read from the source
+    calls = 0;
+    auto limited = cy::seq(1, 10)
+                       .select([&](int x) {
+                           ++calls;
+                           return x;
+                       })
+                       .cache(4);
+    cy::check(limited.sum() == 55);
+    cy::check(limited == cy::seq(1, 10));
+    cy::check(limited.size() == 10);
+    cy::check(!limited.cached());
+    cy::check(calls > 20);
+
+    cy::check(cy::seq<int>().cache().size() == 0);
+    cy::check(cy::seq<int>().cache(0).empty());
+    cy::check(cy::seq(1, 3).cache(0) == cy::list(1, 2, 3));
+}
+
+// A container that records how it was filled
+struct recording_container
+{
+    typedef int value_type;
+    std::vector<int> items;
+    std::size_t reserved = 0, inserts = 0;
+
+    std::vector<int>::iterator end()
+    {
+        return items.end();
+    }
+
+    std::size_t size() const
+    {
+        return items.size();
+    }
+
+    void reserve(std::size_t n)
+    {
+        reserved = n;
+        items.reserve(n);
+    }
+
+    void insert(std::vector<int>::iterator pos, int i)
+    {
+        ++inserts;
+        items.insert(pos, i);
+    }
+
+    void insert(std::vector<int>::iterator pos, const int *first, const int *last)
+    {
+        ++inserts;
+        items.insert(pos, first, last);
+    }
+};
+
+void test_size_hints()
+{
+    using hint = cy::sequences::helpers::size_hint;
+    std::vector<int> v{1, 2, 3, 4, 5};
+    std::list<int> l{1, 2, 3};
+    auto odd = [](int x) { return x % 2 == 1; };
+    auto square = [](int x) { return x * x; };
+
+    auto check_hint = [](hint h, hint::kind_type kind, std::size_t value) {
+        cy::check(h.kind == kind);
+        if (kind != hint::unknown)
+            cy::check(h.value == value);
+    };
+
+    check_hint(cy::seq(v).size_hint(), hint::exact, 5);
+    check_hint(cy::seq(1, 10).select(square).size_hint(), hint::exact, 10);
+    check_hint(cy::seq(v).where(odd).size_hint(), hint::upper_bound, 5);
+    check_hint(cy::seq(v).where(odd).take(3).size_hint(), hint::upper_bound, 3);
+    check_hint(cy::seq(v).where(odd).take(10).size_hint(), hint::upper_bound, 5);
+    check_hint(cy::seq(v).where(odd).skip(2).size_hint(), hint::upper_bound, 3);
+    check_hint(cy::seq(l).size_hint(), hint::unknown, 0);
+    check_hint(cy::seq(l).take(2).size_hint(), hint::upper_bound, 2);
+    check_hint(cy::seq(l).select(square).size_hint(), hint::unknown, 0);
+    check_hint((cy::seq(v) + cy::seq(1, 3)).size_hint(), hint::exact, 8);
+    check_hint((cy::seq(v).where(odd) + cy::seq(1, 3)).size_hint(), hint::upper_bound, 8);
+    check_hint((cy::seq(l) + cy::seq(1, 3)).size_hint(), hint::unknown, 0);
+    check_hint(cy::seq(v).where(odd).repeat(3).size_hint(), hint::upper_bound, 15);
+    check_hint(cy::seq(l).repeat(0).size_hint(), hint::exact, 0);
+    check_hint(cy::seq<int>().size_hint(), hint::exact, 0);
+    check_hint(cy::seq(l).take_while(odd).size_hint(), hint::unknown, 0);
+
+    auto cached = cy::seq(l).where(odd).cache();
+    check_hint(cached.size_hint(), hint::unknown, 0);
+    cached.size();
+    check_hint(cached.size_hint(), hint::exact, 2);
+
+    // Exact sizes are reserved
+    recording_container c1;
+    cy::seq(1, 100).select(square).write_to(c1);
+    cy::check(c1.reserved == 100);
+    cy::check(c1.inserts == 100);
+    cy::check(cy::seq(c1.items) == cy::seq(1, 100).select(square));
+
+    recording_container c2;
+    cy::seq(v).where(odd).write_to(c2);
+    cy::check(c2.reserved == 0);
+    cy::check(c2.items == std::vector<int>{1, 3, 5});
+
+    // Contiguous sequences are inserted in one go
+    recording_container c3;
+    cy::seq(v).write_to(c3);
+    cy::seq(v).skip(3).take(1).write_to(c3);
+    cy::check(c3.inserts == 2);
+    cy::check(c3.items == std::vector<int>{1, 2, 3, 4, 5, 4});
+
+    auto made = cy::seq(1, 1000).make<std::vector<int>>();
+    cy::check(made.size() == 1000 && made.capacity() == 1000);
+    cy::check(cy::seq(v).make<std::vector<int>>() == v);
+    cy::check(cy::list('a', 'b').repeat(3).make<std::string>() == "ababab");
+    cy::check(cy::seq(l).make<std::set<int>>() == std::set<int>{1, 2, 3});
+}
+
+void test_split_view()
+{
+    std::string text = "abc\ndef\r\n   ghi   \n\n";
+    auto lines = cy::seq(text).split_view("\r\n");
+    cy::check(lines == cy::list("abc", "def", "   ghi   "));
+    cy::check(lines == cy::seq(text).split("\r\n"));
+    cy::check(lines.size() == 3);
+
+    // Tokens refer to the original characters
+    cy::check(lines.front().data() == text.data());
+    cy::check(lines.at(1).data() == text.data() + 4);
+
+    // A single delimiter, leading and trailing delimiters, and no tokens
+    cy::check(cy::seq("a,,b,c,").split_view(",") == cy::list("a", "b", "c"));
+    cy::check(cy::seq(",,,").split_view(",").empty());
+    cy::check(cy::seq("").split_view(",").empty());
+    cy::check(cy::seq("a b").split_view("") == cy::list("a b"));
+    cy::check(cy::seq("x").split_view(" \t") == cy::list("x"));
+
+    // Internal iteration can stop early
+    cy::check(cy::seq("a b c d").split_view(" ").take(2) == cy::list("a", "b"));
+    cy::check(cy::seq("a b c d").split_view(" ").any([](std::string_view s) { return s == "c"; }));
+
+    // lines() keeps empty lines and removes "\r\n"
+    cy::check(cy::seq(text).lines() == cy::list("abc", "def", "   ghi   ", ""));
+    cy::check(cy::seq("a").lines() == cy::list("a"));
+    cy::check(cy::seq("\n").lines() == cy::list(""));
+    cy::check(cy::seq("").lines().empty());
+
+    // Wide characters, including delimiters outside the lookup table
+    std::wstring wide = L"one\u2028two three";
+    cy::check(cy::seq(wide).split_view(L"\u2028 ") == cy::list(L"one", L"two", L"three"));
+    cy::check(cy::seq(wide).split(L"\u2028 ") == cy::list(L"one", L"two", L"three"));
+}
+
+void test_csv()
+{
+    std::string text = "name,age,score\r\n"
+                       "Alice,30,1.5\n"
+                       "\"Bob, Jr.\",41,-2\n"
+                       "\n"
+                       "\"Say \"\"hi\"\"\",,\"two\nlines\"\n"
+                       "last,7,";
+    auto csv = cy::seq(text).csv();
+    cy::check(csv.size() == 5);
+
+    auto rows = csv.make<std::vector<cy::sequences::csv_row<char>>>();
+    cy::check(cy::seq(rows[0].cells()) == cy::list("name", "age", "score"));
+    cy::check(rows[1].get<std::string_view>(0) == "Alice");
+    cy::check(rows[1].get<int>(1) == 30);
+    cy::check(rows[1].get<double>(2) == 1.5);
+    cy::check(rows[2][0] == "Bob, Jr.");
+    cy::check(rows[2].get<long>(2) == -2);
+    cy::check(rows[3].size() == 3);
+    cy::check(rows[3][0] == "Say \"hi\"");
+    cy::check(rows[3][1].empty());
+    cy::check(rows[3][2] == "two\nlines");
+    cy::check(rows[4].size() == 3 && rows[4][2].empty());
+
+    // Unescaped cells still refer to their own row after copying
+    auto copy = rows[3];
+    rows[3] = rows[0];
+    cy::check(copy[0] == "Say \"hi\"");
+
+    // And after moving, when the unescaped text is short enough to be stored inside the string
+    auto moved = std::move(copy);
+    cy::check(moved[0] == "Say \"hi\"");
+    copy = std::move(moved);
+    cy::check(copy[0] == "Say \"hi\"");
+
+    // Cells that are not escaped refer to the original text
+    cy::check(rows[1][0].data() == text.data() + text.find("Alice"));
+
+    // Typed access
+    cy::check(!rows[1].try_get<int>(0));
+    cy::check(rows[1].try_get<int>(1) == 30);
+    cy::check_throws<std::invalid_argument>([&] { rows[1].get<int>(0); });
+    cy::check_throws<std::out_of_range>([&] { rows[1].get<int>(3); });
+    cy::check(rows[2].get<std::string>(0) == "Bob, Jr.");
+
+    // Summing a column without storing the rows
+    cy::check(csv.skip(1).take(2).select([](const cy::sequences::csv_row<char> &row) { return row.get<int>(1); }).sum() == 71);
+
+    // Other delimiters, and edge cases
+    cy::check(cy::seq("a;b;c").csv(';').front().size() == 3);
+    cy::check(cy::seq("").csv().empty());
+    cy::check(cy::seq("\r\n\n").csv().empty());
+    cy::check(cy::seq("\"unterminated,x").csv().front()[0] == "unterminated,x");
+    cy::check(cy::seq("\"a\"b,c").csv().front().size() == 2);
+}
+
+void test_mutable_predicates()
+{
+    // Mutable predicates are called in the same way by iterate() and by first()/next()
+    auto alternate = [n = 0](int) mutable { return n++ % 2 == 0; };
+    cy::check(cy::seq(1, 10).where(alternate).sum() == 25);
+    cy::check(cy::seq(1, 10).where(alternate).size() == 5);
+    cy::check(cy::seq(1, 10).where(alternate).any([](int x) { return x == 9; }));
+    cy::check(!cy::seq(1, 10).where(alternate).any([](int x) { return x == 10; }));
+    cy::check(cy::seq(1, 10).take_while([n = 0](int) mutable { return n++ < 3; }).sum() == 6);
+    cy::check(cy::seq(1, 10).skip_until([n = 0](int) mutable { return n++ == 8; }).sum() == 19);
+}
+
 int main()
 {
     test_lifetimes();
@@ -447,5 +1003,15 @@ int main()
     test_count();
     test_aggregate();
     test_accumulate();
+    test_iterate();
+    test_batches();
+    test_kernels();
+    test_random_access();
+    test_parallel();
+    test_cache();
+    test_size_hints();
+    test_split_view();
+    test_csv();
+    test_mutable_predicates();
     return 0;
 }
\ No newline at end of file
@@ -1,3 +1,4 @@
+#include <cutty/persist.hpp>
 #include <cutty/shared_memory.hpp>
 
 #include <cutty/test.hpp>
@@ -5,6 +6,14 @@
 #include <cstring>
 #include <filesystem>
 #include <iostream>
+#include <string>
+#include <vector>
+
+#if !WIN32
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 namespace cy = cutty;
 
@@ -106,7 +115,219 @@ void test1()
     }
 }
 
+void hints()
+{
+    Tmpfile tmp;
+    std::error_code ec;
+    {
+        cy::shared_memory m(tmp.path.string().c_str(), ec,
+                            cy::shared_memory::create | cy::shared_memory::random | cy::shared_memory::huge_pages,
+                            1 << 20);
+        cy::check(m);
+        fill(m);
+        m.advise(ec, 0, 0, cy::shared_memory::hint::willneed);
+        cy::check(!ec);
+        m.advise(ec, 1000, 5000, cy::shared_memory::hint::sequential);
+        cy::check(!ec);
+        m.advise(ec, 0, 0, cy::shared_memory::hint::normal);
+        cy::check(!ec);
+
+        // The hints are reapplied when the mapping grows
+        m.resize(ec, 2 << 20);
+        cy::check(m);
+        cy::check(m.size() == 2 << 20);
+        fill(m);
+    }
+
+    {
+        cy::shared_memory m(tmp.path.string().c_str(), ec,
+                            cy::shared_memory::sequential | cy::shared_memory::prefault);
+        cy::check(m);
+        cy::check(m.size() == 2 << 20);
+        check(m);
+
+        // Outside the mapping does nothing
+        m.advise(ec, m.size(), 0, cy::shared_memory::hint::dontneed);
+        cy::check(!ec);
+    }
+}
+
+void anonymous()
+{
+    std::error_code ec;
+    cy::shared_memory m(ec, 4096);
+    cy::check(m);
+    cy::check(m.size() == 4096);
+    cy::check(m.fd() >= 0);
+    fill(m);
+
+    // Grows like a file
+    m.resize(ec, 8192);
+    cy::check(m.size() == 8192);
+
+    cy::shared_memory sealed(ec, 4096, cy::shared_memory::sealed);
+#if defined(__linux__)
+    cy::check(sealed);
+    sealed.resize(ec, 8192);
+    cy::check(ec);
+#endif
+}
+
+void pass_fd()
+{
+#if !WIN32
+    std::error_code ec;
+    cy::shared_memory m(ec, 4096);
+    std::strcpy((char *)m.data(), "Hello");
+
+    int sockets[2];
+    cy::check(socketpair(AF_UNIX, SOCK_STREAM, 0, sockets) == 0);
+    cy::send_fd(ec, sockets[0], m.fd());
+    cy::check(!ec);
+    int fd = cy::receive_fd(ec, sockets[1]);
+    cy::check(!ec);
+    cy::check(fd >= 0);
+    ::close(sockets[0]);
+    ::close(sockets[1]);
+
+    cy::shared_memory m2(fd, ec);
+    cy::check(m2);
+    cy::check(m2.size() == 4096);
+    cy::check(m2.data() != m.data());
+    cy::check_equal(std::string((char *)m2.data()), "Hello");
+
+    // The memory is shared
+    std::strcpy((char *)m2.data(), "World");
+    cy::check_equal(std::string((char *)m.data()), "World");
+#endif
+}
+
+void anonymous_heap()
+{
+#if !WIN32
+    std::error_code ec;
+    cy::shared_memory m(ec, 16384, 0, (void *)cy::detail::default_map_address);
+    int fd = dup(m.fd());
+
+    cy::map_file file(std::move(m), 0, 0, 0);
+    cy::check(file);
+    cy::check(file.empty());
+    cy::map_data<std::vector<int, cy::allocator<int>>> v{file, cy::allocator<int>(file)};
+    v->push_back(42);
+    void *address = file.root();
+
+    // Maps at a different address, then moves to the heap's address
+    file.close();
+    cy::map_file file2(cy::shared_memory(fd, ec), 0, 0, 0);
+    cy::check(file2);
+    cy::check(file2.root() == address);
+    cy::map_data<std::vector<int, cy::allocator<int>>> v2{file2, cy::allocator<int>(file2)};
+    cy::check_equal(v2->size(), 1u);
+    cy::check_equal((*v2)[0], 42);
+#endif
+}
+
+void preallocate()
+{
+#if !WIN32
+    Tmpfile tmp;
+    std::error_code ec;
+    cy::shared_memory m(tmp.path.string().c_str(), ec, cy::shared_memory::create | cy::shared_memory::preallocate,
+                        1 << 20);
+    cy::check(m);
+    cy::check(m.size() == 1 << 20);
+
+    // The blocks are allocated on disk, so the file is not sparse
+    struct stat st;
+    fstat(m.fd(), &st);
+    cy::check(st.st_blocks * 512 >= 1 << 20);
+
+    m.growth_chunk(1 << 20);
+    cy::check(m.growth_chunk() == 1 << 20);
+    m.resize(ec, (1 << 20) + 4096);
+    cy::check(!ec);
+    cy::check(m.size() == (1 << 20) + 4096);
+    fstat(m.fd(), &st);
+    cy::check(st.st_size == (1 << 20) + 4096);
+    cy::check(st.st_blocks * 512 >= (1 << 20) + 4096);
+    fill(m);
+#endif
+}
+
+void residency()
+{
+#if !WIN32
+    Tmpfile tmp;
+    std::error_code ec;
+    cy::shared_memory m(tmp.path.string().c_str(), ec, cy::shared_memory::create, 1 << 20);
+    fill(m);
+
+    auto r = m.residency(ec);
+    cy::check(!ec);
+    cy::check(r.page_size > 0);
+    cy::check(r.pages.size() == (1 << 20) / r.page_size);
+    cy::check(r.resident_pages == r.pages.size());
+    cy::check(r.fraction() == 1.0);
+
+    // The range is extended to whole pages
+    r = m.residency(ec, r.page_size + 1, 10);
+    cy::check_equal(r.pages.size(), 1u);
+
+    m.evict(ec, 0, 1 << 19);
+    cy::check(!ec);
+    m.evict(ec, 1 << 19, 0, true);
+    cy::check(!ec);
+    m.prefetch(ec);
+    cy::check(!ec);
+
+    // The contents are unaffected
+    check(m);
+#endif
+}
+
+void ring()
+{
+#if !WIN32
+    Tmpfile tmp;
+    std::error_code ec;
+    auto page = std::size_t(sysconf(_SC_PAGESIZE));
+    {
+        cy::shared_memory m(tmp.path.string().c_str(), ec, cy::shared_memory::create | cy::shared_memory::ring, page);
+        cy::check(m);
+        cy::check(m.size() == page);
+
+        // A write that wraps around the end is contiguous
+        char *data = (char *)m.data();
+        std::strcpy(data + page - 3, "Hello");
+        cy::check_equal(std::string(data, 2), "lo");
+        cy::check_equal(std::string(data + page - 3), "Hello");
+
+        // The ring is remapped when it grows
+        m.resize(ec, 2 * page);
+        cy::check(m);
+        data = (char *)m.data();
+        cy::check_equal(std::string(data + page - 3, 3), "Hel");
+        data[2 * page - 1] = 'x';
+        cy::check_equal(data[-1 + 4 * page], 'x');
+        cy::check(data[2 * page] == 'l');
+
+        // The size must be a whole number of pages, and the file and mapping are unchanged if it is not
+        m.resize(ec, page + 1);
+        cy::check(ec == std::errc::invalid_argument);
+        cy::check(m);
+        cy::check(m.size() == 2 * page);
+        cy::check(std::filesystem::file_size(tmp.path) == 2 * page);
+        cy::check(((char *)m.data())[2 * page - 1] == 'x');
+    }
+
+    cy::shared_memory anon(ec, page, cy::shared_memory::ring);
+    cy::check(anon);
+    ((char *)anon.data())[page] = 1;
+    cy::check(((char *)anon.data())[0] == 1);
+#endif
+}
+
 int main()
 {
-    return cy::test({empty_shmem, test1});
+    return cy::test({empty_shmem, test1, hints, anonymous, pass_fd, anonymous_heap, preallocate, residency, ring});
 }
@@ -0,0 +1,84 @@
+#include <cutty/thread_pool.hpp>
+
+#include <cutty/test.hpp>
+
+#include <atomic>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace cy = cutty;
+
+void runs_every_task()
+{
+    cy::thread_pool pool(4);
+    cy::check_equal(pool.size(), 4u);
+
+    std::vector<std::atomic<int>> counts(1000);
+    pool.run(counts.size(), [&](std::size_t i) { ++counts[i]; });
+    for (auto &c : counts)
+        cy::check_equal(c.load(), 1);
+
+    // Empty and single runs
+    pool.run(0, [](std::size_t) { cy::check(false); });
+    int calls = 0;
+    pool.run(1, [&](std::size_t) { ++calls; });
+    cy::check_equal(calls, 1);
+}
+
+void uses_several_threads()
+{
+    cy::thread_pool pool(4);
+    std::mutex mutex;
+    std::set<std::thread::id> threads;
+    std::atomic<int> waiting = 0;
+
+    // Each task waits for the others to start, so they must run on different threads
+    pool.run(4, [&](std::size_t) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            threads.insert(std::this_thread::get_id());
+        }
+        ++waiting;
+        while (waiting < 4)
+            std::this_thread::yield();
+    });
+    cy::check_equal(threads.size(), 4u);
+}
+
+void nested_runs()
+{
+    cy::thread_pool pool(2);
+    std::atomic<int> total = 0;
+    pool.run(8, [&](std::size_t) { pool.run(8, [&](std::size_t j) { total += int(j); }); });
+    cy::check_equal(total.load(), 8 * 28);
+}
+
+void exceptions()
+{
+    cy::thread_pool pool(3);
+    std::atomic<int> completed = 0;
+    cy::check_throws<std::runtime_error>([&] {
+        pool.run(100, [&](std::size_t i) {
+            if (i == 50)
+                throw std::runtime_error("task failed");
+            ++completed;
+        });
+    });
+    cy::check_equal(completed.load(), 99);
+}
+
+void no_threads()
+{
+    cy::thread_pool pool(0);
+    int total = 0;
+    pool.run(10, [&](std::size_t i) { total += int(i); });
+    cy::check_equal(total, 45);
+}
+
+int main()
+{
+    return cy::test({runs_every_task, uses_several_threads, nested_runs, exceptions, no_threads});
+}
@@ -0,0 +1,124 @@
+#include <cutty/windowed_memory.hpp>
+
+#include <cutty/test.hpp>
+
+#include <cstring>
+#include <filesystem>
+#include <vector>
+
+namespace cy = cutty;
+
+struct Tmpfile
+{
+    const std::filesystem::path path;
+
+    Tmpfile(std::filesystem::path p = "windowed.bin") : path(p)
+    {
+        std::filesystem::remove(path);
+    }
+
+    ~Tmpfile()
+    {
+        std::filesystem::remove(path);
+    }
+};
+
+const cy::windowed_memory::size_type window = 65536;
+
+void empty_memory()
+{
+    cy::windowed_memory m;
+    cy::check(!m);
+    std::error_code ec;
+    cy::check(!m.map(ec, 0));
+    cy::check(ec);
+}
+
+void read_and_write()
+{
+    Tmpfile tmp;
+    std::error_code ec;
+    {
+        cy::windowed_memory m(tmp.path.string().c_str(), ec, cy::shared_memory::create, 20 * window, window, 4);
+        cy::check(m);
+        cy::check(m.size() == 20 * window);
+        cy::check_equal(m.mapped_windows(), 0u);
+
+        for (cy::windowed_memory::size_type offset = 0; offset < m.size(); offset += window)
+        {
+            auto v = m.map(ec, offset);
+            cy::check(v);
+            cy::check(v.size() == window);
+            cy::check(v.offset() == offset);
+            std::memset(v.data(), int(offset / window), v.size());
+        }
+
+        // Only the most recent windows are mapped
+        cy::check_equal(m.mapped_windows(), 4u);
+
+        // A view extends to the end of its window
+        auto v = m.map(ec, 5 * window + 100);
+        cy::check(v.size() == window - 100);
+        cy::check_equal(*(char *)v.data(), 5);
+    }
+
+    {
+        cy::windowed_memory m(tmp.path.string().c_str(), ec, cy::shared_memory::readonly | cy::shared_memory::sequential,
+                              0, window, 2);
+        cy::check(m);
+        cy::check(m.size() == 20 * window);
+        for (cy::windowed_memory::size_type offset = 0; offset < m.size(); offset += 1000)
+        {
+            auto v = m.map(ec, offset);
+            cy::check(v);
+            cy::check_equal(*(char *)v.data(), char(offset / window));
+        }
+        cy::check_equal(m.mapped_windows(), 2u);
+
+        // Beyond the end of the file
+        cy::check(!m.map(ec, m.size()));
+        cy::check(ec);
+    }
+}
+
+void pinned_windows()
+{
+    Tmpfile tmp;
+    std::error_code ec;
+    cy::windowed_memory m(tmp.path.string().c_str(), ec, cy::shared_memory::create, 10 * window, window, 2);
+
+    std::vector<cy::windowed_memory::view> views;
+    for (int i = 0; i < 5; ++i)
+        views.push_back(m.map(ec, i * window));
+
+    // Pinned windows are not unmapped
+    cy::check_equal(m.mapped_windows(), 5u);
+
+    // The same window is shared between views
+    auto v = m.map(ec, window + 10);
+    cy::check((char *)v.data() == (char *)views[1].data() + 10);
+
+    views.clear();
+    v.release();
+    cy::check(!v);
+    cy::check_equal(m.mapped_windows(), 2u);
+}
+
+void resize()
+{
+    Tmpfile tmp;
+    std::error_code ec;
+    cy::windowed_memory m(tmp.path.string().c_str(), ec, cy::shared_memory::create, window + 100, window, 4);
+    cy::check(m.map(ec, window).size() == 100);
+
+    m.resize(ec, 3 * window);
+    cy::check(!ec);
+    cy::check(m.size() == 3 * window);
+    cy::check(m.map(ec, window).size() == window);
+    cy::check(m.map(ec, 2 * window + 5).size() == window - 5);
+}
+
+int main()
+{
+    return cy::test({empty_memory, read_and_write, pinned_windows, resize});
+}
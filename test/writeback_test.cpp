@@ -0,0 +1,154 @@
+#include <cutty/writeback.hpp>
+
+#include <cutty/test.hpp>
+
+#include <cstring>
+#include <filesystem>
+#include <thread>
+
+namespace cy = cutty;
+
+using namespace std::chrono_literals;
+
+struct Tmpfile
+{
+    const std::filesystem::path path;
+
+    Tmpfile(std::filesystem::path p = "writeback.bin") : path(p)
+    {
+        std::filesystem::remove(path);
+    }
+
+    ~Tmpfile()
+    {
+        std::filesystem::remove(path);
+    }
+};
+
+// Waits for the background thread to flush
+bool wait_for_flush(const cy::writeback &wb)
+{
+    for (int i = 0; i < 500; ++i)
+    {
+        if (wb.dirty_bytes() == 0 && wb.stats().flushes > 0)
+            return true;
+        std::this_thread::sleep_for(10ms);
+    }
+    return false;
+}
+
+void merge_ranges()
+{
+    Tmpfile tmp;
+    std::error_code ec;
+    cy::shared_memory m(tmp.path.string().c_str(), ec, cy::shared_memory::create, 1 << 20);
+
+    cy::writeback::policy p;
+    p.max_age = 1h;
+    cy::writeback wb(m, p);
+
+    wb.mark_dirty(0, 100);
+    wb.mark_dirty(50, 100);
+    wb.mark_dirty(150, 50);
+    wb.mark_dirty(1000, 10);
+    cy::check(wb.dirty_bytes() == 210);
+
+    wb.flush(ec);
+    cy::check(!ec);
+    cy::check(wb.dirty_bytes() == 0);
+    auto stats = wb.stats();
+    cy::check_equal(stats.flushes, 2u);
+    cy::check(stats.bytes == 210);
+    cy::check_equal(stats.errors, 0u);
+    cy::check(stats.max_latency <= stats.total_latency);
+    cy::check(stats.mean_latency() <= stats.max_latency);
+}
+
+void dirty_threshold()
+{
+    Tmpfile tmp;
+    std::error_code ec;
+    cy::shared_memory m(tmp.path.string().c_str(), ec, cy::shared_memory::create, 1 << 20);
+
+    cy::writeback::policy p;
+    p.dirty_bytes = 1 << 16;
+    p.max_age = 1h;
+    cy::writeback wb(m, p);
+
+    // Exactly reaches the threshold
+    for (int i = 0; i < 16; ++i)
+    {
+        std::memset((char *)m.data() + i * 4096, i, 4096);
+        wb.mark_dirty(i * 4096, 4096);
+    }
+    cy::check(wait_for_flush(wb));
+    cy::check(wb.stats().bytes == 1 << 16);
+}
+
+void age_threshold()
+{
+    Tmpfile tmp;
+    std::error_code ec;
+    cy::shared_memory m(tmp.path.string().c_str(), ec, cy::shared_memory::create, 1 << 20);
+
+    cy::writeback::policy p;
+    p.max_age = 20ms;
+    p.interval = 5ms;
+    p.sync = true;
+    cy::writeback wb(m, p);
+
+    std::strcpy((char *)m.data(), "Hello");
+    wb.mark_dirty(0, 6);
+    cy::check(wait_for_flush(wb));
+}
+
+void sync_after_background_flush()
+{
+    Tmpfile tmp;
+    std::error_code ec;
+    cy::shared_memory m(tmp.path.string().c_str(), ec, cy::shared_memory::create, 1 << 20);
+
+    cy::writeback::policy p;
+    p.dirty_bytes = 4096;
+    p.max_age = 1h;
+    cy::writeback wb(m, p);
+
+    std::memset(m.data(), 1, 4096);
+    wb.mark_dirty(0, 4096);
+    cy::check(wait_for_flush(wb));
+
+    // The background flush only started writeback, so a synchronous flush issues it again
+    wb.flush(ec);
+    cy::check(!ec);
+    cy::check_equal(wb.stats().flushes, 2u);
+    cy::check(wb.stats().bytes == 8192);
+
+    // Once synced, the range is not flushed again
+    wb.flush(ec);
+    cy::check_equal(wb.stats().flushes, 2u);
+}
+
+void flush_on_destruction()
+{
+    Tmpfile tmp;
+    std::error_code ec;
+    cy::shared_memory m(tmp.path.string().c_str(), ec, cy::shared_memory::create, 1 << 20);
+    {
+        cy::writeback::policy p;
+        p.max_age = 1h;
+        cy::writeback wb(m, p);
+        wb.mark_dirty(0, 4096);
+    }
+
+    // Flushing a range directly
+    m.flush(ec, 100, 10, false);
+    cy::check(!ec);
+    m.flush(ec);
+    cy::check(!ec);
+}
+
+int main()
+{
+    return cy::test({merge_ranges, dirty_threshold, age_threshold, sync_after_background_flush,
+                     flush_on_destruction});
+}